@@ -0,0 +1,367 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "answergraph.h"
+#include "batchrouter.h"
+#include "chatlogic.h"
+#include "conversationengine.h"
+#include "graphedge.h"
+#include "graphfile.h"
+#include "graphloader.h"
+#include "graphnode.h"
+#include "graphparser.h"
+#include "levenshtein.h"
+#include "rng.h"
+#include "syntheticgraph.h"
+#include "textnormalizer.h"
+
+namespace
+{
+// generated graphs are written once per process into the temporary directory
+std::string GetSyntheticGraphFile(const SyntheticGraphOptions &options, bool binary = false)
+{
+    static std::map<std::string, std::string> files;
+    std::string name = "membot_bench_" + std::to_string(options.numNodes) + "_" + std::to_string(options.fanout) + "_" +
+                       std::to_string(options.keywordsPerEdge) + "_" + std::to_string(options.answerLength);
+    std::string key = name + (binary ? ".bin" : ".txt");
+    auto it = files.find(key);
+    if (it != files.end())
+        return it->second;
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+    std::string text = (dir / (name + ".txt")).string();
+    if (files.find(name + ".txt") == files.end())
+    {
+        WriteSyntheticAnswerGraph(text, options);
+        files[name + ".txt"] = text;
+    }
+    if (!binary)
+        return text;
+
+    std::string bin = (dir / (name + ".bin")).string();
+    GraphRecords records;
+    ParseAnswerGraphFile(text, records);
+    WriteAnswerGraphFile(bin, records);
+    files[key] = bin;
+    return bin;
+}
+
+SyntheticGraphOptions LoaderGraphOptions(size_t numNodes)
+{
+    SyntheticGraphOptions options;
+    options.numNodes = numNodes;
+    options.answerLength = 64;
+    return options;
+}
+
+// user messages drawn like the keywords of synthetic graphs, so some of them are close matches
+std::vector<std::string> RandomMessages(size_t count, uint64_t seed)
+{
+    Pcg32 rng(seed);
+    std::vector<std::string> messages;
+    for (size_t i = 0; i < count; ++i)
+        messages.push_back(RandomWord(rng));
+    return messages;
+}
+} // namespace
+
+// edit distance of two random strings with the given lengths
+static void BM_LevenshteinDistance(benchmark::State &state)
+{
+    Pcg32 rng(1);
+    std::string a = RandomWord(rng, state.range(0), state.range(0));
+    std::string b = RandomWord(rng, state.range(1), state.range(1));
+    LevenshteinEngine engine;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(engine.ComputeDistance(a, b));
+    state.counters["cells"] = benchmark::Counter(double(a.size() * b.size()) * state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_LevenshteinDistance)->Args({4, 4})->Args({8, 12})->Args({16, 16})->Args({32, 48})->Args({64, 64})->Args({100, 120})->Args({200, 200});
+
+// original dynamic programming implementation, for comparison
+static void BM_LevenshteinDistanceReference(benchmark::State &state)
+{
+    Pcg32 rng(1);
+    std::string a = RandomWord(rng, state.range(0), state.range(0));
+    std::string b = RandomWord(rng, state.range(1), state.range(1));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(LevenshteinEngine::ComputeDistanceReference(a, b));
+}
+BENCHMARK(BM_LevenshteinDistanceReference)->Args({4, 4})->Args({16, 16})->Args({64, 64})->Args({200, 200});
+
+// normalization of a random message with the given length, vectorized (0) or scalar (1)
+static void BM_NormalizeText(benchmark::State &state)
+{
+    Pcg32 rng(4);
+    std::string message;
+    while (message.size() < size_t(state.range(0)))
+        message += RandomWord(rng, 1, 8) + (rng.NextBelow(4) == 0 ? ", " : " ");
+    message.resize(state.range(0));
+
+    std::string normalized;
+    for (auto _ : state)
+    {
+        if (state.range(1) == 0)
+            NormalizeText(message, normalized);
+        else
+            NormalizeTextScalar(message, normalized);
+        benchmark::DoNotOptimize(normalized.data());
+    }
+    state.SetBytesProcessed(int64_t(message.size()) * state.iterations());
+    state.SetLabel(state.range(1) == 0 ? GetTextNormalizerKernel() : "scalar");
+}
+BENCHMARK(BM_NormalizeText)->ArgsProduct({{16, 64, 256, 1024}, {0, 1}});
+
+// routing step of ChatBot::ReceiveMessageFromUser on a root node with the given number of keywords
+static void BM_RouteMessage(benchmark::State &state)
+{
+    SyntheticGraphOptions options;
+    options.numNodes = state.range(0) + 1;
+    options.fanout = state.range(0);
+    options.keywordsPerEdge = 1;
+    std::unique_ptr<AnswerGraph> graph = LoadAnswerGraph(GetSyntheticGraphFile(options));
+    if (graph == nullptr)
+    {
+        state.SkipWithError("graph could not be loaded");
+        return;
+    }
+
+    std::vector<std::string> messages;
+    for (const std::string &message : RandomMessages(64, 2))
+        NormalizeText(message, messages.emplace_back());
+    const GraphNode *root = graph->GetRootNode();
+    LevenshteinEngine engine;
+    size_t i = 0;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(graph->SelectNextNode(root, messages[i++ & 63], engine));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RouteMessage)->Arg(1)->Arg(10)->Arg(100)->Arg(1000);
+
+// the same with a response cache, after the first round every message is a hit
+static void BM_RouteMessageCached(benchmark::State &state)
+{
+    SyntheticGraphOptions options;
+    options.numNodes = state.range(0) + 1;
+    options.fanout = state.range(0);
+    options.keywordsPerEdge = 1;
+    std::unique_ptr<AnswerGraph> graph = LoadAnswerGraph(GetSyntheticGraphFile(options));
+    if (graph == nullptr)
+    {
+        state.SkipWithError("graph could not be loaded");
+        return;
+    }
+    graph->EnableResponseCache(1024);
+
+    std::vector<std::string> messages;
+    for (const std::string &message : RandomMessages(64, 2))
+        NormalizeText(message, messages.emplace_back());
+    const GraphNode *root = graph->GetRootNode();
+    LevenshteinEngine engine;
+    size_t i = 0;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(graph->SelectNextNode(root, messages[i++ & 63], engine));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RouteMessageCached)->Arg(1)->Arg(10)->Arg(100)->Arg(1000);
+
+// the same with messages equal to keywords of the root node, which are routed by the exact keyword tables
+static void BM_RouteExactKeyword(benchmark::State &state)
+{
+    SyntheticGraphOptions options;
+    options.numNodes = state.range(0) + 1;
+    options.fanout = state.range(0);
+    options.keywordsPerEdge = 1;
+    std::unique_ptr<AnswerGraph> graph = LoadAnswerGraph(GetSyntheticGraphFile(options));
+    if (graph == nullptr)
+    {
+        state.SkipWithError("graph could not be loaded");
+        return;
+    }
+
+    std::vector<std::string> messages;
+    const GraphNode *root = graph->GetRootNode();
+    for (size_t i = 0; i < 64; ++i)
+    {
+        for (std::string_view keyword : root->GetChildEdgeAtIndex(i % root->GetNumberOfChildEdges())->GetKeywords())
+            NormalizeText(keyword, messages.emplace_back());
+    }
+    LevenshteinEngine engine;
+    size_t i = 0;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(graph->SelectNextNode(root, messages[i++ % messages.size()], engine));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RouteExactKeyword)->Arg(1)->Arg(10)->Arg(100)->Arg(1000);
+
+// routing of sentences with the given number of words, one of them a keyword of the root node,
+// against the whole message (0) or against its words (1)
+static void BM_RouteSentence(benchmark::State &state)
+{
+    SyntheticGraphOptions options;
+    options.numNodes = 101;
+    options.fanout = 100;
+    options.keywordsPerEdge = 1;
+    std::unique_ptr<AnswerGraph> graph = LoadAnswerGraph(GetSyntheticGraphFile(options));
+    if (graph == nullptr)
+    {
+        state.SkipWithError("graph could not be loaded");
+        return;
+    }
+    if (state.range(1) != 0)
+        graph->EnableWordMatching();
+
+    const GraphNode *root = graph->GetRootNode();
+    Pcg32 rng(3);
+    std::vector<std::string> messages;
+    for (int i = 0; i < 64; ++i)
+    {
+        std::string message;
+        size_t keywordPosition = rng.NextBelow(state.range(0));
+        for (size_t w = 0; w < size_t(state.range(0)); ++w)
+        {
+            const GraphEdge *edge = root->GetChildEdgeAtIndex(rng.NextBelow(root->GetNumberOfChildEdges()));
+            message += (w == keywordPosition ? std::string(edge->GetKeywords()[0]) : RandomWord(rng)) + " ";
+        }
+        NormalizeText(message, messages.emplace_back());
+    }
+
+    LevenshteinEngine engine;
+    size_t i = 0;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(graph->SelectNextNode(root, messages[i++ & 63], engine));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RouteSentence)->ArgsProduct({{4, 16, 64}, {0, 1}});
+
+// text parser only, on the given number of threads
+static void BM_ParseAnswerGraph(benchmark::State &state)
+{
+    std::string filename = GetSyntheticGraphFile(LoaderGraphOptions(state.range(0)));
+    size_t bytes = std::filesystem::file_size(filename);
+    for (auto _ : state)
+    {
+        GraphRecords records;
+        ParseAnswerGraphFile(filename, records, state.range(1));
+        benchmark::DoNotOptimize(records.nodes.data());
+    }
+    state.SetBytesProcessed(int64_t(bytes) * state.iterations());
+}
+BENCHMARK(BM_ParseAnswerGraph)->ArgsProduct({{1000, 10000, 100000, 1000000}, {1, 2, 4, 8}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// what ChatLogic::LoadAnswerGraphFromFile does before the chatbot is created, in text and binary format
+static void BM_LoadAnswerGraph(benchmark::State &state)
+{
+    std::string filename = GetSyntheticGraphFile(LoaderGraphOptions(state.range(0)), state.range(1) != 0);
+    size_t bytes = std::filesystem::file_size(filename);
+    for (auto _ : state)
+    {
+        std::unique_ptr<AnswerGraph> graph = LoadAnswerGraph(filename);
+        benchmark::DoNotOptimize(graph.get());
+    }
+    state.SetBytesProcessed(int64_t(bytes) * state.iterations());
+    state.SetLabel(state.range(1) ? "binary" : "text");
+}
+BENCHMARK(BM_LoadAnswerGraph)->ArgsProduct({{1000, 10000, 100000, 1000000}, {0, 1}})->Unit(benchmark::kMillisecond);
+
+// the same for a root node with the given number of keywords, which bounds the cost of its keyword tables
+static void BM_LoadWideNode(benchmark::State &state)
+{
+    SyntheticGraphOptions options;
+    options.numNodes = state.range(0) + 1;
+    options.fanout = state.range(0);
+    options.keywordsPerEdge = 1;
+    std::string filename = GetSyntheticGraphFile(options);
+    for (auto _ : state)
+    {
+        std::unique_ptr<AnswerGraph> graph = LoadAnswerGraph(filename);
+        benchmark::DoNotOptimize(graph.get());
+    }
+    state.SetItemsProcessed(state.range(0) * state.iterations());
+}
+BENCHMARK(BM_LoadWideNode)->Arg(100)->Arg(1000)->Arg(2000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+// conversation turns through ChatLogic and ChatBot, as used by membot_cli
+static void BM_ChatLogicTurn(benchmark::State &state)
+{
+    ChatLogic chatLogic;
+    chatLogic.SetRandomSeed(3);
+    chatLogic.SetResponseHandler([](std::string_view response) { benchmark::DoNotOptimize(response.data()); });
+    SyntheticGraphOptions options;
+    options.numNodes = 10000;
+    if (!chatLogic.LoadAnswerGraphFromFile(GetSyntheticGraphFile(options)))
+    {
+        state.SkipWithError("graph could not be loaded");
+        return;
+    }
+
+    std::vector<std::string> messages = RandomMessages(64, 4);
+    size_t i = 0;
+    for (auto _ : state)
+        chatLogic.SendMessageToChatbot(messages[i++ & 63]);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ChatLogicTurn);
+
+// headless conversation turns with one session per thread on a shared graph
+static void BM_ConversationEngineTurns(benchmark::State &state)
+{
+    static std::unique_ptr<ConversationEngine> engine;
+    if (state.thread_index() == 0)
+    {
+        SyntheticGraphOptions options;
+        options.numNodes = 10000;
+        std::shared_ptr<const AnswerGraph> graph = LoadAnswerGraph(GetSyntheticGraphFile(options));
+        engine = std::make_unique<ConversationEngine>(graph, 16, 5);
+    }
+
+    // the benchmark library synchronizes all threads before and after the timed loop
+    ConversationEngine::SessionID session = ConversationEngine::kInvalidSession;
+    std::vector<std::string> messages = RandomMessages(64, 6 + state.thread_index());
+    std::string answer;
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        if (session == ConversationEngine::kInvalidSession)
+            session = engine->CreateSession();
+        engine->Respond(session, messages[i++ & 63], answer);
+    }
+    state.SetItemsProcessed(state.iterations());
+    engine->EndSession(session);
+}
+BENCHMARK(BM_ConversationEngineTurns)->ThreadRange(1, 8)->UseRealTime();
+
+// offline replay of 100000 messages from random start nodes with the given number of threads
+static void BM_BatchRoute(benchmark::State &state)
+{
+    SyntheticGraphOptions options;
+    options.numNodes = 10000;
+    std::shared_ptr<const AnswerGraph> graph = LoadAnswerGraph(GetSyntheticGraphFile(options));
+    if (graph == nullptr)
+    {
+        state.SkipWithError("graph could not be loaded");
+        return;
+    }
+
+    Pcg32 rng(7);
+    std::vector<BatchRouter::Request> requests;
+    for (int i = 0; i < 100000; ++i)
+        requests.push_back(BatchRouter::Request{graph->GetNodeAtIndex(rng.NextBelow(graph->GetNumberOfNodes()))->GetID(), RandomWord(rng)});
+
+    BatchRouter router(graph, state.range(0));
+    std::vector<BatchRouter::Result> results;
+    for (auto _ : state)
+    {
+        router.Route(requests, results);
+        benchmark::DoNotOptimize(results.data());
+    }
+    state.SetItemsProcessed(int64_t(requests.size()) * state.iterations());
+}
+BENCHMARK(BM_BatchRoute)->RangeMultiplier(2)->Range(1, 8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,55 @@
+#include <fstream>
+#include <vector>
+
+#include "rng.h"
+#include "syntheticgraph.h"
+
+std::string RandomWord(Pcg32 &rng, size_t minLength, size_t maxLength)
+{
+    std::string word(minLength + rng.NextBelow(uint32_t(maxLength - minLength + 1)), 'a');
+    for (char &c : word)
+        c = char('a' + rng.NextBelow(26));
+    return word;
+}
+
+size_t WriteSyntheticAnswerGraph(const std::string &filename, const SyntheticGraphOptions &options)
+{
+    std::ofstream file(filename, std::ios::trunc | std::ios::binary);
+    if (!file)
+        return 0;
+
+    Pcg32 rng(options.seed);
+    std::vector<std::string> vocabulary;
+    for (size_t i = 0; i < options.vocabularySize; ++i)
+        vocabulary.push_back(RandomWord(rng));
+
+    std::string answer(options.answerLength, ' ');
+    std::string line;
+    size_t bytes = 0;
+    for (size_t i = 0; i < options.numNodes; ++i)
+    {
+        line = "<TYPE:NODE><ID:" + std::to_string(i) + ">";
+        for (size_t a = 0; a < options.answersPerNode; ++a)
+        {
+            for (char &c : answer)
+                c = char('a' + rng.NextBelow(26));
+            line += "<ANSWER:" + answer + ">";
+        }
+        line += "\n";
+
+        // the edge leading to this node is defined right after it, the parent exists already
+        if (i > 0)
+        {
+            line += "<TYPE:EDGE><ID:" + std::to_string(i) + "><PARENT:" + std::to_string((i - 1) / options.fanout) +
+                    "><CHILD:" + std::to_string(i) + ">";
+            for (size_t k = 0; k < options.keywordsPerEdge; ++k)
+                line += "<KEYWORD:" + (vocabulary.empty() ? RandomWord(rng) : vocabulary[rng.NextBelow(uint32_t(vocabulary.size()))]) + ">";
+            line += "\n";
+        }
+
+        file << line;
+        bytes += line.size();
+    }
+
+    return file ? bytes : 0;
+}
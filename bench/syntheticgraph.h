@@ -0,0 +1,28 @@
+#ifndef SYNTHETICGRAPH_H_
+#define SYNTHETICGRAPH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class Pcg32; // forward declaration
+
+// shape of a generated answer graph: node 0 is the root, node i > 0 is a child of node (i - 1) / fanout
+struct SyntheticGraphOptions
+{
+    size_t numNodes = 1000;
+    size_t fanout = 4;          // child edges per inner node
+    size_t keywordsPerEdge = 2; // random words of 4 to 12 letters
+    size_t vocabularySize = 0;  // keywords are drawn from this many words (0: every keyword is a new word)
+    size_t answersPerNode = 1;
+    size_t answerLength = 100;  // characters per answer
+    uint64_t seed = 1;          // same options and seed give the same file
+};
+
+// random lower-case word, keywords of generated graphs are drawn the same way
+std::string RandomWord(Pcg32 &rng, size_t minLength = 4, size_t maxLength = 12);
+
+// writes a graph in the text format of answergraph.txt, returns the number of bytes or 0 on error
+size_t WriteSyntheticAnswerGraph(const std::string &filename, const SyntheticGraphOptions &options);
+
+#endif /* SYNTHETICGRAPH_H_ */
@@ -0,0 +1,414 @@
+
+#include <cstring>
+
+#include "instrumentation.h"
+#include "log.h"
+#include "graphfile.h"
+#include "levenshtein.h"
+#include "textnormalizer.h"
+#include "answergraph.h"
+
+namespace
+{
+// 64-bit hash of a sequence of values and strings, which reads strings 8 bytes at a time
+class ContentHasher
+{
+private:
+    uint64_t _hash = 0x6A09E667F3BCC908ull;
+
+public:
+    void Add(uint64_t value)
+    {
+        _hash = (_hash ^ value) * 0x9E3779B97F4A7C15ull;
+        _hash ^= _hash >> 32;
+    }
+
+    void Add(std::string_view str)
+    {
+        // the length separates adjacent strings
+        Add(str.size());
+        size_t i = 0;
+        for (; i + 8 <= str.size(); i += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, str.data() + i, 8);
+            Add(word);
+        }
+        if (i < str.size())
+        {
+            uint64_t tail = 0;
+            std::memcpy(&tail, str.data() + i, str.size() - i);
+            Add(tail);
+        }
+    }
+
+    uint64_t Get() const
+    {
+        // finalizer of splitmix64
+        uint64_t hash = (_hash ^ (_hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+        hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+        return hash ^ (hash >> 31);
+    }
+};
+} // namespace
+
+AnswerGraph::AnswerGraph()
+{
+    _rootNode = 0;
+    _isFinalized = false;
+    _matchWords = false;
+    _refs = nullptr;
+    _chars = nullptr;
+    _fingerprint = 0;
+}
+
+AnswerGraph::~AnswerGraph()
+{
+    // the binary file (if any) is unmapped after all views into it are gone
+}
+
+void AnswerGraph::Reserve(size_t numNodes, size_t numEdges, size_t numChars)
+{
+    _nodes.reserve(numNodes);
+    _edges.reserve(numEdges);
+    _pool.Reserve(numChars);
+}
+
+void AnswerGraph::PrepareNodeIndex(int minId, int maxId, size_t numNodes)
+{
+    _nodeIndex.Reset(minId, maxId, numNodes);
+}
+
+GraphNode *AnswerGraph::AddNode(int id)
+{
+    if (!_nodeIndex.Insert(id, _nodes.size()))
+        return nullptr;
+
+    _nodes.emplace_back(this, id);
+    return &_nodes.back();
+}
+
+GraphEdge *AnswerGraph::AddEdge(int id, int parentId, int childId)
+{
+    uint32_t parent = _nodeIndex.Find(parentId);
+    uint32_t child = _nodeIndex.Find(childId);
+    if (parent == NodeIndex::kNotFound || child == NodeIndex::kNotFound)
+        return nullptr;
+
+    _edges.emplace_back(this, id, parent, child);
+    return &_edges.back();
+}
+
+void AnswerGraph::AddAnswer(const GraphNode *node, std::string_view answer)
+{
+    _pendingAnswers.emplace_back(uint32_t(node - _nodes.data()), _pool.Add(answer));
+}
+
+void AnswerGraph::AddKeyword(const GraphEdge *edge, std::string_view keyword)
+{
+    _pendingKeywords.emplace_back(uint32_t(edge - _edges.data()), _pool.Add(keyword));
+}
+
+const GraphNode *AnswerGraph::FindNode(int id) const
+{
+    uint32_t index = _nodeIndex.Find(id);
+    return index == NodeIndex::kNotFound ? nullptr : &_nodes[index];
+}
+
+const GraphNode *AnswerGraph::SelectNextNode(const GraphNode *current, std::string_view normalizedMessage, LevenshteinEngine &engine, int *distance, const GraphEdge **edge) const
+{
+    MEMBOT_SCOPED_TIMER(kStageEdgeScan);
+
+    // messages equal to a keyword and repeated messages skip the keyword matching
+    // (an equal keyword is the best match of the whole message and, as the longest one at distance zero, of its words)
+    uint32_t node = GetNodeIndex(current);
+    ResponseCache::Route route;
+    int exactEntry = _exactIndex.FindEntry(node, normalizedMessage, current->_firstMatchEntry);
+    if (exactEntry >= 0)
+    {
+        route = ResponseCache::Route{int(_matchEntries[exactEntry].edgeIndex), 0};
+        MEMBOT_COUNT(kCounterExactMatchHits, 1);
+    }
+    else if (_responseCache == nullptr || !_responseCache->Find(node, normalizedMessage, route))
+    {
+        // find the child edge whose keywords are closest to the query (in terms of Levenshtein distance)
+        // when matching words, the whole message is only used if none of its words is close to a keyword
+        KeywordMatcher matcher = current->GetKeywordMatcher();
+        route.distance = -1;
+        route.edgeIndex = _matchWords ? matcher.FindBestEdgeInWords(normalizedMessage, engine, &route.distance) : -1;
+        if (route.edgeIndex < 0)
+            route.edgeIndex = matcher.FindBestEdge(normalizedMessage, engine, &route.distance);
+        if (route.edgeIndex < 0)
+            route.distance = -1;
+
+        if (_responseCache != nullptr)
+            _responseCache->Insert(node, normalizedMessage, route);
+    }
+
+    // select best fitting edge to proceed along or go back to root node
+    const GraphEdge *selected = route.edgeIndex >= 0 ? current->GetChildEdgeAtIndex(route.edgeIndex) : nullptr;
+    if (distance != nullptr)
+        *distance = route.distance;
+    if (edge != nullptr)
+        *edge = selected;
+
+    return selected != nullptr ? selected->GetChildNode() : GetRootNode();
+}
+
+bool AnswerGraph::Finalize()
+{
+    if (_isFinalized)
+        return true;
+
+    // group edges by parent node with a stable counting sort (siblings keep their order)
+    std::vector<uint32_t> offsets(_nodes.size() + 1, 0);
+    for (const GraphEdge &edge : _edges)
+    {
+        offsets[edge._parentNode + 1]++;
+        _nodes[edge._childNode]._numParents++;
+    }
+    for (size_t i = 0; i < _nodes.size(); ++i)
+    {
+        _nodes[i]._firstChildEdge = offsets[i];
+        _nodes[i]._numChildEdges = offsets[i + 1];
+        offsets[i + 1] += offsets[i];
+    }
+
+    std::vector<uint32_t> newEdgeIndex(_edges.size());
+    std::vector<GraphEdge> edges;
+    for (size_t i = 0; i < _edges.size(); ++i)
+        newEdgeIndex[i] = offsets[_edges[i]._parentNode]++;
+    edges.resize(_edges.size(), GraphEdge(this, 0, 0, 0));
+    for (size_t i = 0; i < _edges.size(); ++i)
+        edges[newEdgeIndex[i]] = _edges[i];
+    _edges.swap(edges);
+
+    // store answers per node, then keywords per edge, as contiguous ranges of string references
+    _stringRefs.clear();
+    _stringRefs.reserve(_pendingAnswers.size() + _pendingKeywords.size());
+
+    std::vector<uint32_t> counts(_nodes.size() + 1, 0);
+    for (const auto &answer : _pendingAnswers)
+        counts[answer.first + 1]++;
+    for (size_t i = 0; i < _nodes.size(); ++i)
+    {
+        _nodes[i]._firstAnswer = counts[i];
+        _nodes[i]._numAnswers = counts[i + 1];
+        counts[i + 1] += counts[i];
+    }
+    _stringRefs.resize(_pendingAnswers.size());
+    for (const auto &answer : _pendingAnswers)
+        _stringRefs[counts[answer.first]++] = answer.second;
+
+    counts.assign(_edges.size() + 1, 0);
+    for (const auto &keyword : _pendingKeywords)
+        counts[newEdgeIndex[keyword.first] + 1]++;
+    for (size_t i = 0; i < _edges.size(); ++i)
+    {
+        _edges[i]._firstKeyword = _stringRefs.size() + counts[i];
+        _edges[i]._numKeywords = counts[i + 1];
+        counts[i + 1] += counts[i];
+    }
+    size_t firstKeyword = _stringRefs.size();
+    _stringRefs.resize(firstKeyword + _pendingKeywords.size());
+    for (const auto &keyword : _pendingKeywords)
+        _stringRefs[firstKeyword + counts[newEdgeIndex[keyword.first]]++] = keyword.second;
+
+    std::vector<std::pair<uint32_t, StringRef>>().swap(_pendingAnswers);
+    std::vector<std::pair<uint32_t, StringRef>>().swap(_pendingKeywords);
+
+    // equal answers and keywords (e.g. "yes" on many edges) share their characters from now on
+    StringPool pool;
+    pool.Intern(_pool, _stringRefs.data(), _stringRefs.size());
+    pool.ReleaseInternTable();
+    _pool = std::move(pool);
+
+    _refs = _stringRefs.data();
+    _chars = _pool.GetData();
+    _isFinalized = true;
+
+    BuildKeywordMatchers();
+    return FindRootNode();
+}
+
+bool AnswerGraph::CreateFromBinaryFile(std::unique_ptr<AnswerGraphFile> file)
+{
+    // node and edge tables are already resolved and grouped, only the handles need to be set up
+    _nodes.clear();
+    _edges.clear();
+    Reserve(file->GetNumberOfNodes(), file->GetNumberOfEdges());
+    _nodeIndex.Clear();
+
+    for (uint32_t i = 0; i < file->GetNumberOfNodes(); ++i)
+    {
+        const AnswerGraphFileNode &fileNode = file->GetNode(i);
+        if (!_nodeIndex.Insert(fileNode.id, i))
+        {
+            MEMBOT_LOG_ERROR("Error: duplicate node " << fileNode.id << " in binary answer graph");
+            return false;
+        }
+
+        _nodes.emplace_back(this, fileNode.id);
+        GraphNode &node = _nodes.back();
+        node._firstChildEdge = file->GetFirstChildEdge(i);
+        node._numChildEdges = file->GetEndOfChildEdges(i) - file->GetFirstChildEdge(i);
+        node._numParents = fileNode.numParents;
+        node._firstAnswer = fileNode.firstAnswer;
+        node._numAnswers = fileNode.numAnswers;
+    }
+
+    for (uint32_t i = 0; i < file->GetNumberOfEdges(); ++i)
+    {
+        const AnswerGraphFileEdge &fileEdge = file->GetEdge(i);
+        _edges.emplace_back(this, fileEdge.id, fileEdge.parent, fileEdge.child);
+        _edges.back()._firstKeyword = fileEdge.firstKeyword;
+        _edges.back()._numKeywords = fileEdge.numKeywords;
+    }
+
+    // strings are used in place
+    _refs = file->GetStringRefs();
+    _chars = file->GetStringData();
+    _file = std::move(file);
+    _isFinalized = true;
+
+    BuildKeywordMatchers();
+    return FindRootNode();
+}
+
+void AnswerGraph::BuildKeywordMatchers()
+{
+    // keywords are normalized like the messages they are compared with, in the order of the edges
+    StringPool normalized;
+    std::vector<StringRef> keywords;
+    std::string buffer;
+    for (const GraphEdge &edge : _edges)
+    {
+        for (std::string_view keyword : edge.GetKeywords())
+        {
+            NormalizeText(keyword, buffer);
+            keywords.push_back(normalized.Add(buffer));
+        }
+    }
+
+    // equal normalized keywords are stored once
+    StringPool matchPool;
+    std::vector<uint64_t> hashes;
+    matchPool.Intern(normalized, keywords.data(), keywords.size(), &hashes);
+    _matchEntries.clear();
+    _matchEntries.reserve(keywords.size());
+    std::vector<uint64_t> entryHashes;
+    entryHashes.reserve(keywords.size());
+    std::vector<uint32_t> nodeOffsets;
+    nodeOffsets.reserve(_nodes.size() + 1);
+
+    // a repeated keyword of the same node never wins (the first one does on equal distance), so it is matched
+    // only once; equal keywords have equal offsets, so the last node that used a keyword is stamped at its offset
+    // (an empty keyword shares its offset with the next interned one and is stamped separately)
+    std::vector<uint32_t> keywordStamps(matchPool.GetSize(), 0);
+    uint32_t emptyStamp = 0;
+
+    // edges are grouped by parent, so the entries of each node are contiguous as well
+    const StringRef *keyword = keywords.data();
+    for (GraphNode &node : _nodes)
+    {
+        uint32_t stamp = uint32_t(&node - _nodes.data()) + 1;
+        node._firstMatchEntry = _matchEntries.size();
+        for (uint32_t i = 0; i < node._numChildEdges; ++i)
+        {
+            for (const StringRef *end = keyword + _edges[node._firstChildEdge + i]._numKeywords; keyword != end; ++keyword)
+            {
+                uint32_t &used = keyword->length == 0 ? emptyStamp : keywordStamps[keyword->offset];
+                if (used == stamp)
+                    continue;
+                used = stamp;
+
+                _matchEntries.push_back(KeywordMatcher::Entry{keyword->offset, keyword->length, i});
+                entryHashes.push_back(hashes[keyword - keywords.data()]);
+            }
+        }
+        node._numMatchEntries = _matchEntries.size() - node._firstMatchEntry;
+        nodeOffsets.push_back(node._firstMatchEntry);
+    }
+    nodeOffsets.push_back(_matchEntries.size());
+
+    _matchBuffer.assign(matchPool.GetData(), matchPool.GetSize());
+    _exactIndex.Build(_matchBuffer.data(), _matchEntries.data(), nodeOffsets, entryHashes);
+}
+
+void AnswerGraph::EnableWordMatching()
+{
+    // one index for the whole graph, the entries of each node are a contiguous range of it
+    _tokenIndex.Build(_matchBuffer.data(), _matchEntries.data(), _matchEntries.size());
+    _matchWords = true;
+
+    // decisions of the whole-message matching no longer apply
+    if (_responseCache != nullptr)
+        _responseCache->Clear();
+}
+
+void AnswerGraph::EnableResponseCache(size_t capacity)
+{
+    // node indices are only valid in this graph, so a reloaded graph always starts with an empty cache
+    _responseCache = capacity > 0 ? std::make_unique<ResponseCache>(capacity) : nullptr;
+}
+
+bool AnswerGraph::FindRootNode()
+{
+    // search for nodes which have no incoming edges
+    bool found = false;
+    for (size_t i = 0; i < _nodes.size(); ++i)
+    {
+        if (_nodes[i]._numParents == 0)
+        {
+            if (!found)
+            {
+                _rootNode = i; // assign current node to root
+                found = true;
+            }
+            else
+            {
+                MEMBOT_LOG_ERROR("ERROR : Multiple root nodes detected");
+            }
+        }
+    }
+
+    if (!found)
+        MEMBOT_LOG_ERROR("Error: no root node found");
+
+    return found;
+}
+
+uint64_t AnswerGraph::GetFingerprint() const
+{
+    // hashing all strings of a large graph takes a moment, so graphs that are never compared do not pay for it
+    std::call_once(_fingerprintFlag, [this]() { _fingerprint = ComputeFingerprint(); });
+    return _fingerprint;
+}
+
+uint64_t AnswerGraph::ComputeFingerprint() const
+{
+    // IDs, answers and keywords in graph order; the order of nodes and edges is the same in both formats
+    ContentHasher hasher;
+    hasher.Add(_nodes.size());
+    for (const GraphNode &node : _nodes)
+    {
+        hasher.Add(uint64_t(uint32_t(node.GetID())));
+        StringList answers = node.GetAnswers();
+        hasher.Add(answers.size());
+        for (std::string_view answer : answers)
+            hasher.Add(answer);
+    }
+
+    hasher.Add(_edges.size());
+    for (const GraphEdge &edge : _edges)
+    {
+        hasher.Add(uint64_t(uint32_t(edge.GetID())));
+        hasher.Add(uint64_t(uint32_t(edge.GetParentNode()->GetID())));
+        hasher.Add(uint64_t(uint32_t(edge.GetChildNode()->GetID())));
+        StringList keywords = edge.GetKeywords();
+        hasher.Add(keywords.size());
+        for (std::string_view keyword : keywords)
+            hasher.Add(keyword);
+    }
+    return hasher.Get();
+}
@@ -0,0 +1,114 @@
+#ifndef ANSWERGRAPH_H_
+#define ANSWERGRAPH_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "graphnode.h"
+#include "graphedge.h"
+#include "exactmatchindex.h"
+#include "keywordmatcher.h"
+#include "nodeindex.h"
+#include "responsecache.h"
+#include "stringpool.h"
+#include "tokenindex.h"
+
+class AnswerGraphFile;   // forward declaration
+class LevenshteinEngine; // forward declaration
+
+// Answer graph stored in a few flat arrays: nodes, edges grouped by parent node (CSR),
+// string references and a shared string pool. GraphNode and GraphEdge are small handles
+// into these arrays. A graph is filled with AddNode / AddEdge / AddToken and then finalized,
+// or created in one go from a memory-mapped binary file whose string pool is used in place.
+class AnswerGraph
+{
+private:
+    // proprietary members
+    std::vector<GraphNode> _nodes; // all nodes in order of creation
+    std::vector<GraphEdge> _edges; // all edges, grouped by parent node once finalized
+    NodeIndex _nodeIndex;          // position in _nodes per node ID
+    uint32_t _rootNode;
+    bool _isFinalized;
+
+    // string storage, owned or borrowed from a binary file
+    StringPool _pool;                       // equal strings are stored once after finalizing
+    std::vector<StringRef> _stringRefs;     // answers of each node and keywords of each edge are contiguous
+    std::unique_ptr<AnswerGraphFile> _file; // keeps the memory mapping alive
+    const StringRef *_refs;                 // either _stringRefs or the string table of _file
+    const char *_chars;                     // either _pool or the string data of _file
+
+    // keyword matching data (normalized keywords and one entry per keyword, grouped by node)
+    std::string _matchBuffer;
+    std::vector<KeywordMatcher::Entry> _matchEntries;
+    ExactMatchIndex _exactIndex;   // messages equal to a keyword skip the Levenshtein scan
+    KeywordTokenIndex _tokenIndex; // only built if keywords are matched against the words of a message
+    bool _matchWords;
+
+    // routing decisions for repeated messages, only if enabled (synchronized internally, so it is used by const functions)
+    std::unique_ptr<ResponseCache> _responseCache;
+
+    // content hash, computed on first use (see GetFingerprint)
+    mutable std::once_flag _fingerprintFlag;
+    mutable uint64_t _fingerprint;
+
+    // tokens added while the graph is being built, grouped by element when finalizing
+    std::vector<std::pair<uint32_t, StringRef>> _pendingAnswers;  // <node,answer>
+    std::vector<std::pair<uint32_t, StringRef>> _pendingKeywords; // <edge,keyword>
+
+    // proprietary functions
+    void BuildKeywordMatchers();
+    bool FindRootNode();
+    uint64_t ComputeFingerprint() const;
+
+public:
+    // constructor / destructor
+    AnswerGraph();
+    ~AnswerGraph();
+
+    // nodes and edges point back at their graph, so it can neither be copied nor moved
+    AnswerGraph(const AnswerGraph &source) = delete;
+    AnswerGraph &operator=(const AnswerGraph &source) = delete;
+
+    // building (returned pointers are valid until the next node or edge is added)
+    void Reserve(size_t numNodes, size_t numEdges, size_t numChars = 0); // numChars of all answers and keywords
+    void PrepareNodeIndex(int minId, int maxId, size_t numNodes);
+    GraphNode *AddNode(int id);                               // returns nullptr if the ID exists already
+    GraphEdge *AddEdge(int id, int parentId, int childId);    // returns nullptr if a node ID is missing
+    void AddAnswer(const GraphNode *node, std::string_view answer);
+    void AddKeyword(const GraphEdge *edge, std::string_view keyword);
+    bool Finalize();                                          // returns false if there is no root node
+    bool CreateFromBinaryFile(std::unique_ptr<AnswerGraphFile> file);
+    void EnableWordMatching();                                // builds the word index, call after Finalize / CreateFromBinaryFile
+    void EnableResponseCache(size_t capacity);                // caches up to capacity routing decisions, 0 disables the cache
+
+    // getter / setter
+    size_t GetNumberOfNodes() const { return _nodes.size(); }
+    size_t GetNumberOfEdges() const { return _edges.size(); }
+    const GraphNode *GetNodeAtIndex(uint32_t index) const { return &_nodes[index]; }
+    const GraphEdge *GetEdgeAtIndex(uint32_t index) const { return &_edges[index]; }
+    uint32_t GetNodeIndex(const GraphNode *node) const { return node - _nodes.data(); }
+    const GraphNode *GetRootNode() const { return _nodes.empty() ? nullptr : &_nodes[_rootNode]; }
+    const GraphNode *FindNode(int id) const;
+    bool IsWordMatchingEnabled() const { return _matchWords; }
+    ResponseCache *GetResponseCache() const { return _responseCache.get(); } // nullptr if disabled
+    uint64_t GetFingerprint() const; // equal for equal graphs, whether loaded from the text or the binary format
+    StringList GetStrings(uint32_t first, uint32_t count) const { return StringList(_refs + first, _chars, count); }
+    KeywordMatcher GetKeywordMatcher(uint32_t first, uint32_t count) const { return KeywordMatcher(_matchBuffer.data(), _matchEntries.data() + first, count, _matchWords ? &_tokenIndex : nullptr, first); }
+
+    // proprietary functions
+    // returns the child reached via the closest keyword, or the root node if there are no child edges
+    // (with word matching, a keyword close to some words of the message is preferred over the whole message),
+    // the message must have been normalized with NormalizeText, the distance of the selected keyword
+    // and the edge taken are optionally returned as well (-1 and nullptr for the root node fallback);
+    // a message equal to a keyword is routed by table lookup, and with a response cache a repeated
+    // (node, message) pair is answered from the cache
+    const GraphNode *SelectNextNode(const GraphNode *current, std::string_view normalizedMessage, LevenshteinEngine &engine,
+                                    int *distance = nullptr, const GraphEdge **edge = nullptr) const;
+};
+
+#endif /* ANSWERGRAPH_H_ */
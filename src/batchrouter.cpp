@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+#include "answergraph.h"
+#include "graphedge.h"
+#include "graphnode.h"
+#include "textnormalizer.h"
+#include "batchrouter.h"
+
+BatchRouter::BatchRouter(std::shared_ptr<const AnswerGraph> graph, size_t numThreads, size_t taskSize)
+    : _graph(std::move(graph)), _pool(numThreads), _taskSize(taskSize > 0 ? taskSize : 1)
+{
+    _scratch.resize(_pool.GetNumberOfWorkers());
+}
+
+void BatchRouter::Route(const std::vector<Request> &requests, std::vector<Result> &results)
+{
+    // requests with an unknown start node keep this result
+    results.assign(requests.size(), Result{-1, -1, -1});
+
+    // group the requests by start node with a counting sort (requests of a node keep their order)
+    const uint32_t kUnknownNode = UINT32_MAX;
+    std::vector<uint32_t> startNodes(requests.size());
+    std::vector<uint32_t> offsets(_graph->GetNumberOfNodes() + 1, 0);
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        const GraphNode *node = _graph->FindNode(requests[i].startNodeID);
+        startNodes[i] = node != nullptr ? _graph->GetNodeIndex(node) : kUnknownNode;
+        if (node != nullptr)
+            offsets[startNodes[i] + 1]++;
+    }
+    for (size_t i = 0; i + 1 < offsets.size(); ++i)
+        offsets[i + 1] += offsets[i];
+
+    std::vector<uint32_t> order(offsets.back());
+    std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        if (startNodes[i] != kUnknownNode)
+            order[next[startNodes[i]]++] = i;
+    }
+
+    // one task per node, nodes with many requests are split so that the pool can balance them
+    std::vector<std::pair<uint32_t, uint32_t>> tasks; // <begin,end> in order
+    for (size_t node = 0; node + 1 < offsets.size(); ++node)
+    {
+        for (uint32_t begin = offsets[node]; begin < offsets[node + 1]; begin += _taskSize)
+            tasks.emplace_back(begin, std::min<uint32_t>(begin + _taskSize, offsets[node + 1]));
+    }
+
+    _pool.Run(tasks.size(), [&](size_t task, size_t worker) {
+        WorkerScratch &scratch = _scratch[worker];
+        for (uint32_t i = tasks[task].first; i < tasks[task].second; ++i)
+        {
+            uint32_t request = order[i];
+            const GraphNode *start = _graph->GetNodeAtIndex(startNodes[request]);
+
+            NormalizeText(requests[request].message, scratch.normalizedMessage);
+            int distance = -1;
+            const GraphEdge *edge = nullptr;
+            const GraphNode *child = _graph->SelectNextNode(start, scratch.normalizedMessage, scratch.levenshtein, &distance, &edge);
+
+            // every task writes its own results, so no synchronization is needed
+            results[request] = Result{edge != nullptr ? edge->GetID() : -1, child->GetID(), distance};
+        }
+    });
+}
@@ -0,0 +1,64 @@
+#ifndef BATCHROUTER_H_
+#define BATCHROUTER_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "levenshtein.h"
+#include "workstealingpool.h"
+
+class AnswerGraph; // forward declaration
+
+// Routes many messages at once, e.g. to replay logged conversations against a new version of the
+// answer graph. Messages are grouped by their start node, so the keywords of a node stay in cache
+// while all of its messages are matched, and the groups are spread over the cores with a
+// work-stealing pool. Each message is matched exactly as ChatBot::ReceiveMessageFromUser would.
+class BatchRouter
+{
+public:
+    // proprietary type definitions
+    struct Request
+    {
+        int startNodeID;     // node the user is at when sending the message
+        std::string message; // as typed by the user, it is normalized by the router
+    };
+
+    struct Result
+    {
+        int edgeID;      // edge taken, -1 if the start node has no child edges (back to the root node)
+        int childNodeID; // node reached, -1 if the start node does not exist
+        int distance;    // Levenshtein distance of the closest keyword, -1 if no edge was taken
+    };
+
+private:
+    // scratch memory of one worker
+    struct WorkerScratch
+    {
+        LevenshteinEngine levenshtein;
+        std::string normalizedMessage;
+    };
+
+    // data handles (shared)
+    std::shared_ptr<const AnswerGraph> _graph;
+
+    // proprietary members
+    WorkStealingPool _pool;
+    std::vector<WorkerScratch> _scratch; // one per worker of _pool
+    size_t _taskSize;                    // messages per task at most, larger groups are split
+
+public:
+    // constructor
+    BatchRouter(std::shared_ptr<const AnswerGraph> graph, size_t numThreads = 0, size_t taskSize = 256); // 0 uses all hardware threads
+
+    // getter / setter
+    const AnswerGraph *GetAnswerGraph() const { return _graph.get(); }
+    size_t GetNumberOfThreads() const { return _pool.GetNumberOfWorkers(); }
+
+    // proprietary functions
+    // fills one result per request (in the same order), calls must not overlap
+    void Route(const std::vector<Request> &requests, std::vector<Result> &results);
+};
+
+#endif /* BATCHROUTER_H_ */
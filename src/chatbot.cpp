@@ -1,33 +1,38 @@
-#include <iostream>
-#include <random>
-#include <algorithm>
-#include <ctime>
 
+#include "instrumentation.h"
+#include "log.h"
 #include "chatlogic.h"
+#include "answergraph.h"
 #include "graphnode.h"
 #include "graphedge.h"
+#include "textnormalizer.h"
 #include "chatbot.h"
 
 // constructor WITHOUT memory allocation
 ChatBot::ChatBot()
 {
     // invalidate data handles
-    _image = nullptr;
     _chatLogic = nullptr;
-    _rootNode = nullptr;
+    _graph = nullptr;
+    _currentNode = 0;
+    _rootNode = 0;
+    _rng.Seed(Pcg32::RandomSeed());
 }
 
-// constructor WITH memory allocation
+// constructor with the path of the avatar image
 ChatBot::ChatBot(std::string filename)
 {
-    std::cout << "ChatBot Constructor" << std::endl;
+    MEMBOT_LOG_DEBUG("ChatBot Constructor");
     
     // invalidate data handles
     _chatLogic = nullptr;
-    _rootNode = nullptr;
+    _graph = nullptr;
+    _currentNode = 0;
+    _rootNode = 0;
+    _rng.Seed(Pcg32::RandomSeed());
 
-    // load image into heap memory
-    _image = new wxBitmap(filename, wxBITMAP_TYPE_PNG);
+    // the image is loaded by the front end (if it shows one), the core only keeps its path
+    _imageFilename = filename;
 }
 
 // Rule of Five
@@ -35,14 +40,7 @@ ChatBot::ChatBot(std::string filename)
 // Destructor
 ChatBot::~ChatBot()
 {
-    std::cout << "ChatBot Destructor" << std::endl;
-
-    // deallocate heap memory
-    if(_image != NULL) // Attention: wxWidgets used NULL and not nullptr
-    {
-        delete _image;
-        _image = NULL;
-    }
+    MEMBOT_LOG_DEBUG("ChatBot Destructor");
 }
 
 /* Copy Constructor
@@ -51,12 +49,14 @@ allocates a block of memory of the same size as in the source and then
 copies the data into its members (as a deep copy)
 */
 ChatBot::ChatBot(const ChatBot &source) {
-    std::cout<< "ChatBot Copy Constructor" << std::endl;
+    MEMBOT_LOG_DEBUG("ChatBot Copy Constructor");
 
-    this->_image = new wxBitmap(*source._image);
-    // Copy _currentNode and _rootNode from source or create a new GraphNode, with ID from the source 
-    this->_currentNode = new GraphNode(source._currentNode->GetID());
-    this->_rootNode = new GraphNode(source._rootNode->GetID());
+    this->_imageFilename = source._imageFilename;
+    // the answer graph is immutable, so it is shared and the node indices are copied
+    this->_graph = source._graph;
+    this->_currentNode = source._currentNode;
+    this->_rootNode = source._rootNode;
+    this->_rng = source._rng;
     // Copy the source chatLogic 
     this->_chatLogic = source._chatLogic;
 
@@ -71,16 +71,18 @@ ChatBot::ChatBot(const ChatBot &source) {
     by which they promise that they won't (and can't) modify the content of source.
 */
 ChatBot &ChatBot::operator=(const ChatBot &source) {
-    std::cout<< "ChatBot Copy Assignment operator" << std::endl;
+    MEMBOT_LOG_DEBUG("ChatBot Copy Assignment operator");
     //std::cout << "ASSIGNING content of instance " <<  &source << " to instance " << this << std::endl;
 
     if(this== &source)
         return *this;
 
-    this->_image = new wxBitmap(*source._image);
-    // Copy _currentNode and _rootNode from source or create a new GraphNode, with ID from the source 
-    this->_currentNode = new GraphNode(source._currentNode->GetID());
-    this->_rootNode = new GraphNode(source._rootNode->GetID());
+    this->_imageFilename = source._imageFilename;
+    // the answer graph is immutable, so it is shared and the node indices are copied
+    this->_graph = source._graph;
+    this->_currentNode = source._currentNode;
+    this->_rootNode = source._rootNode;
+    this->_rng = source._rng;
     // Copy the source chatLogic 
     this->_chatLogic = source._chatLogic;
 
@@ -99,20 +101,23 @@ ChatBot &ChatBot::operator=(const ChatBot &source) {
     memory on destruction - the ownership has been successfully changed (or moved) without the need 
     to copy the data on the heap.
 */
-ChatBot::ChatBot(ChatBot &&source){
-    std::cout<< "ChatBot Move constructor" << std::endl;
+ChatBot::ChatBot(ChatBot &&source) noexcept {
+    MEMBOT_LOG_DEBUG("ChatBot Move constructor");
     //std::cout << "MOVING (constructor) instance " <<  &source << " to instance " << this << std::endl;
 
     // Copy the data handle from source to target (this)
-    this->_image = source._image;
+    this->_imageFilename = std::move(source._imageFilename);
+    this->_graph = source._graph;
     this->_currentNode = source._currentNode;
     this->_rootNode = source._rootNode;
+    this->_rng = source._rng;
     this->_chatLogic = source._chatLogic;
 
     // invalidate source data handle
-    source._image = NULL; // Attention: wxWidgets used NULL and not nullptr
-    source._currentNode = nullptr;
-    source._rootNode = nullptr;
+    source._imageFilename.clear();
+    source._graph = nullptr;
+    source._currentNode = 0;
+    source._rootNode = 0;
     source._chatLogic = nullptr;
 }
 
@@ -120,123 +125,67 @@ ChatBot::ChatBot(ChatBot &&source){
     Move Assignment operator
     Identical to the Move constructor, apart from returning a reference to the own instance using this.
 */
-ChatBot &ChatBot::operator=(ChatBot &&source) {
-    std:: cout<< "ChatBot Move Assignment operator" << std::endl;
+ChatBot &ChatBot::operator=(ChatBot &&source) noexcept {
+    MEMBOT_LOG_DEBUG("ChatBot Move Assignment operator");
     //std::cout << "MOVING (assign) instance " <<  &source << " to instance " << this << std::endl;
 
     if(this== &source)
         return *this;
 
     // Copy the data handle from source to target (this)
-    this->_image = source._image;
+    this->_imageFilename = std::move(source._imageFilename);
+    this->_graph = source._graph;
     this->_currentNode = source._currentNode;
     this->_rootNode = source._rootNode;
+    this->_rng = source._rng;
     this->_chatLogic = source._chatLogic;
 
     // invalidate source data handle
-    source._image = NULL; // Attention: wxWidgets used NULL and not nullptr
-    source._currentNode = nullptr;
-    source._rootNode = nullptr;
+    source._imageFilename.clear();
+    source._graph = nullptr;
+    source._currentNode = 0;
+    source._rootNode = 0;
     source._chatLogic = nullptr;
 
     return *this;
 }
 
-void ChatBot::ReceiveMessageFromUser(std::string message)
+void ChatBot::ReceiveMessageFromUser(const std::string &message)
 {
-    // loop over all edges and keywords and compute Levenshtein distance to query
-    typedef std::pair<GraphEdge *, int> EdgeDist;
-    std::vector<EdgeDist> levDists; // format is <ptr,levDist>
-
-    for (size_t i = 0; i < _currentNode->GetNumberOfChildEdges(); ++i)
-    {
-        GraphEdge *edge = _currentNode->GetChildEdgeAtIndex(i);
-        for (auto keyword : edge->GetKeywords())
-        {
-            EdgeDist ed{edge, ComputeLevenshteinDistance(keyword, message)};
-            levDists.push_back(ed);
-        }
-    }
-
-    // select best fitting edge to proceed along
-    GraphNode *newNode;
-    if (levDists.size() > 0)
-    {
-        // sort in ascending order of Levenshtein distance (best fit is at the top)
-        std::sort(levDists.begin(), levDists.end(), [](const EdgeDist &a, const EdgeDist &b) { return a.second < b.second; });
-        newNode = levDists.at(0).first->GetChildNode(); // after sorting the best edge is at first position
-    }
-    else
-    {
-        // go back to root node
-        newNode = _rootNode;
-    }
-
-    // tell current node to move chatbot to new node
-    _currentNode->MoveChatbotToNewNode(newNode);
+    // normalize the message once, it is compared with every keyword of the current node
+    NormalizeText(message, _normalizedMessage);
+
+    // select best fitting edge to proceed along (or go back to root node)
+    const GraphNode *newNode = _graph->SelectNextNode(_graph->GetNodeAtIndex(_currentNode), _normalizedMessage, _levenshtein);
+
+    // the graph stays untouched, only the index of the current node changes
+    SetCurrentNode(newNode);
 }
 
-void ChatBot::SetCurrentNode(GraphNode *node)
+void ChatBot::ChangeAnswerGraph(const AnswerGraph *graph)
 {
-    // update pointer to current node
-    _currentNode = node;
-
-    // select a random node answer (if several answers should exist)
-    std::vector<std::string> answers = _currentNode->GetAnswers();
-    std::mt19937 generator(int(std::time(0)));
-    std::uniform_int_distribution<int> dis(0, answers.size() - 1);
-    std::string answer = answers.at(dis(generator));
+    // node indices differ between graphs, node IDs are what the answer graph file defines
+    const GraphNode *node = graph->FindNode(_graph->GetNodeAtIndex(_currentNode)->GetID());
+    if (node == nullptr)
+        node = graph->GetRootNode();
+
+    _graph = graph;
+    _rootNode = graph->GetNodeIndex(graph->GetRootNode());
+    _currentNode = graph->GetNodeIndex(node);
+}
 
-    // send selected node answer to user
-    _chatLogic->SendMessageToUser(answer);
+void ChatBot::SetRootNode(const GraphNode *rootNode)
+{
+    _rootNode = _graph->GetNodeIndex(rootNode);
 }
 
-int ChatBot::ComputeLevenshteinDistance(std::string s1, std::string s2)
+void ChatBot::SetCurrentNode(const GraphNode *node)
 {
-    // convert both strings to upper-case before comparing
-    std::transform(s1.begin(), s1.end(), s1.begin(), ::toupper);
-    std::transform(s2.begin(), s2.end(), s2.begin(), ::toupper);
-
-    // compute Levenshtein distance measure between both strings
-    const size_t m(s1.size());
-    const size_t n(s2.size());
-
-    if (m == 0)
-        return n;
-    if (n == 0)
-        return m;
-
-    size_t *costs = new size_t[n + 1];
-
-    for (size_t k = 0; k <= n; k++)
-        costs[k] = k;
-
-    size_t i = 0;
-    for (std::string::const_iterator it1 = s1.begin(); it1 != s1.end(); ++it1, ++i)
-    {
-        costs[0] = i + 1;
-        size_t corner = i;
-
-        size_t j = 0;
-        for (std::string::const_iterator it2 = s2.begin(); it2 != s2.end(); ++it2, ++j)
-        {
-            size_t upper = costs[j + 1];
-            if (*it1 == *it2)
-            {
-                costs[j + 1] = corner;
-            }
-            else
-            {
-                size_t t(upper < corner ? upper : corner);
-                costs[j + 1] = (costs[j] < t ? costs[j] : t) + 1;
-            }
-
-            corner = upper;
-        }
-    }
-
-    int result = costs[n];
-    delete[] costs;
-
-    return result;
-}
\ No newline at end of file
+    MEMBOT_SCOPED_TIMER(kStageNodeTransition);
+
+    // update index of current node
+    _currentNode = _graph->GetNodeIndex(node);
+
+    // send a randomly selected node answer to user (without copying it)
+    _chatLogic->SendMessageToUser(node->SelectAnswer(_rng));
+}
@@ -1,48 +1,56 @@
 #ifndef CHATBOT_H_
 #define CHATBOT_H_
 
-#include <wx/bitmap.h>
+#include <cstdint>
 #include <string>
 
-class GraphNode; // forward declaration
-class ChatLogic; // forward declaration
+#include "levenshtein.h"
+#include "rng.h"
+
+class AnswerGraph; // forward declaration
+class GraphNode;   // forward declaration
+class ChatLogic;   // forward declaration
 
 class ChatBot
 {
 private:
-    // data handles (owned)
-    wxBitmap *_image; // avatar image
-
     // data handles (not owned)
-    GraphNode *_currentNode;
-    GraphNode *_rootNode;
+    const AnswerGraph *_graph; // immutable, may be shared by many chatbots
     ChatLogic *_chatLogic;
 
-    // proprietary functions
-    int ComputeLevenshteinDistance(std::string s1, std::string s2);
+    // proprietary members
+    std::string _imageFilename;     // avatar image, loaded by the GUI (the core does not depend on wxWidgets)
+    uint32_t _currentNode;          // index of the current node in _graph (the whole conversation state)
+    uint32_t _rootNode;             // index of the root node in _graph
+    LevenshteinEngine _levenshtein; // reusable scratch memory for string matching
+    std::string _normalizedMessage; // reusable scratch memory for the normalized user message
+    Pcg32 _rng;                     // selects one of several answers, seeded once
 
 public:
     // constructors / destructors
     ChatBot();                     // constructor WITHOUT memory allocation
-    ChatBot(std::string filename); // constructor WITH memory allocation
+    ChatBot(std::string filename); // constructor with the path of the avatar image
     
     // Rule of Five
     ~ChatBot(); //destuctor
     ChatBot(const ChatBot &source);  //copy constructor
     ChatBot &operator=(const ChatBot &source); //copy assignment operator
-    ChatBot(ChatBot &&source); //move constructor
-    ChatBot &operator=(ChatBot &&source); //move assignment operator  
+    ChatBot(ChatBot &&source) noexcept; //move constructor
+    ChatBot &operator=(ChatBot &&source) noexcept; //move assignment operator
     
     // getters / setters
     ChatLogic* GetChatLogicHandle() { return _chatLogic; }
     
-    void SetCurrentNode(GraphNode *node);
-    void SetRootNode(GraphNode *rootNode) { _rootNode = rootNode; }
+    void SetAnswerGraph(const AnswerGraph *graph) { _graph = graph; }
+    void ChangeAnswerGraph(const AnswerGraph *graph); // continues at the node with the same ID (or at the root node) without an answer
+    void SetCurrentNode(const GraphNode *node);
+    void SetRootNode(const GraphNode *rootNode);
     void SetChatLogicHandle(ChatLogic *chatLogic) { _chatLogic = chatLogic; }
-    wxBitmap *GetImageHandle() { return _image; }
+    void SetRandomSeed(uint64_t seed) { _rng.Seed(seed); } // for reproducible conversations
+    const std::string &GetImageFilename() const { return _imageFilename; }
 
     // communication
-    void ReceiveMessageFromUser(std::string message);
+    void ReceiveMessageFromUser(const std::string &message);
 };
 
 #endif /* CHATBOT_H_ */
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "chatlogic.h"
+#include "instrumentation.h"
+#ifdef MEMBOT_EMBEDDED_ANSWER_GRAPH
+#include "embeddedgraph.h"
+#endif
+
+// headless front end: reads one user message per line from stdin and writes one answer per line to stdout,
+// so it can be scripted or served over a socket by an inetd-style launcher (e.g. socat ... EXEC:membot_cli)
+int main(int argc, char *argv[])
+{
+    // metrics and trace exports are configured through the environment
+    ConfigureInstrumentationFromEnvironment();
+
+    // a fixed seed makes the selection among several answers reproducible (e.g. for load tests),
+    // matching keywords against single words suits long messages, --cache N remembers the routing of up to
+    // N repeated messages and --watch reloads a changed graph file
+    ChatLogic chatLogic;
+    bool watch = false;
+    int arg = 1;
+    for (; arg < argc; ++arg)
+    {
+        std::string option(argv[arg]);
+        if (option == "--seed" && arg + 1 < argc)
+            chatLogic.SetRandomSeed(std::strtoull(argv[++arg], nullptr, 10));
+        else if (option == "--words")
+            chatLogic.SetWordMatching(true);
+        else if (option == "--cache" && arg + 1 < argc)
+            chatLogic.SetResponseCache(std::strtoull(argv[++arg], nullptr, 10));
+        else if (option == "--watch")
+            watch = true;
+        else
+            break;
+    }
+
+    if (argc > arg + 1)
+    {
+        std::cout << "Usage: membot_cli [--seed N] [--words] [--cache N] [--watch] [answergraph.txt | answergraph.bin]" << std::endl;
+        return 2;
+    }
+
+    chatLogic.SetResponseHandler([](std::string_view response) { std::cout << "BOT: " << response << std::endl; });
+#ifdef MEMBOT_EMBEDDED_ANSWER_GRAPH
+    // without a file argument the graph compiled into the executable is used (it cannot be watched)
+    if (arg == argc)
+    {
+        size_t size;
+        const void *image = GetEmbeddedAnswerGraph(size);
+        if (!chatLogic.LoadAnswerGraphFromImage(image, size))
+            return 1;
+        watch = false;
+    }
+    else if (!chatLogic.LoadAnswerGraphFromFile(argv[arg]))
+        return 1;
+#else
+    std::string filename = arg < argc ? argv[arg] : "../src/answergraph.txt";
+    if (!chatLogic.LoadAnswerGraphFromFile(filename))
+        return 1;
+#endif
+    if (watch)
+        chatLogic.EnableHotReload();
+
+    std::string message;
+    while (std::getline(std::cin, message))
+        chatLogic.SendMessageToChatbot(message);
+
+    return 0;
+}
@@ -1,24 +1,91 @@
 #include <wx/filename.h>
 #include <wx/colour.h>
 #include <wx/image.h>
+#include <wx/dcbuffer.h>
+#include <algorithm>
 #include <string>
+#include "instrumentation.h"
+#include "log.h"
 #include "chatbot.h"
 #include "chatlogic.h"
+#include "chatworker.h"
+#include "imagecache.h"
+#ifdef MEMBOT_EMBEDDED_ANSWER_GRAPH
+#include "embeddedgraph.h"
+#endif
 #include "chatgui.h"
-#include <iostream>
 
 // size of chatbot window
 const int width = 414;
 const int height = 736;
 
+// layout of dialog items
+const int dialogItemBorder = 8;  // space around each item
+const int dialogItemPadding = 1; // space around text and avatar
+const int dialogTextWidth = 150; // text is wrapped after this many pixels
+
+// delay after the last size event of a live resize before the background is rescaled with high quality
+const int resizeDebounceMs = 150;
+
 // wxWidgets APP
 IMPLEMENT_APP(ChatBotApp);
 
+wxDEFINE_EVENT(EVT_CHATBOT_RESPONSE, wxThreadEvent);
+
 std::string dataPath = "../";
 std::string imgBasePath = dataPath + "images/";
 
+BackgroundBitmap::BackgroundBitmap(wxWindow *owner, const std::string &filename)
+    : _owner(owner), _isHighQuality(false), _resizeTimer(owner)
+{
+    // decode the image once, all paint events use the cached bitmap
+    if (!_image.LoadFile(filename))
+        MEMBOT_LOG_ERROR("Error: background image " << filename << " could not be loaded");
+
+    _owner->Bind(wxEVT_SIZE, &BackgroundBitmap::OnSize, this);
+    _owner->Bind(wxEVT_TIMER, &BackgroundBitmap::OnResizeTimer, this, _resizeTimer.GetId());
+}
+
+void BackgroundBitmap::OnSize(wxSizeEvent &evt)
+{
+    // restart the debounce timer on each size event of a live resize
+    _resizeTimer.Start(resizeDebounceMs, wxTIMER_ONE_SHOT);
+    evt.Skip(); // sizers still need to see the event
+}
+
+void BackgroundBitmap::OnResizeTimer(wxTimerEvent &evt)
+{
+    // the size is stable, so the next paint rescales with high quality
+    if (!_isHighQuality || _bitmapSize != _owner->GetSize())
+        _owner->Refresh(false);
+}
+
+void BackgroundBitmap::Draw(wxDC &dc)
+{
+    wxSize sz = _owner->GetSize();
+    if (!_image.IsOk() || sz.GetWidth() <= 0 || sz.GetHeight() <= 0)
+        return;
+
+    // rescale image to fit window dimensions, but only if these have changed since the last paint
+    bool isResizing = _resizeTimer.IsRunning();
+    if (sz != _bitmapSize || (!_isHighQuality && !isResizing))
+    {
+        _bitmap = wxBitmap(_image.Scale(sz.GetWidth(), sz.GetHeight(), isResizing ? wxIMAGE_QUALITY_NORMAL : wxIMAGE_QUALITY_HIGH));
+        _bitmapSize = sz;
+        _isHighQuality = !isResizing;
+    }
+
+    dc.DrawBitmap(_bitmap, 0, 0, false);
+}
+
 bool ChatBotApp::OnInit()
 {
+    // allow for PNG and JPEG images to be handled (background images are decoded when the windows are created)
+    wxInitAllImageHandlers();
+
+    // metrics and trace exports are configured through the environment
+    ConfigureInstrumentationFromEnvironment();
+
     // create window with name and show it
     ChatBotFrame *chatBotFrame = new ChatBotFrame(wxT("Udacity ChatBot"));
     chatBotFrame->Show(true);
@@ -54,7 +121,7 @@ ChatBotFrame::ChatBotFrame(const wxString &title) : wxFrame(NULL, wxID_ANY, titl
 void ChatBotFrame::OnEnter(wxCommandEvent &WXUNUSED(event))
 {
     // retrieve text from text control
-    wxString userText = _userTextCtrl->GetLineText(0);
+    std::string userText(_userTextCtrl->GetLineText(0).utf8_str());
 
     // add new user text to dialog
     _panelDialog->AddDialogItem(userText, true);
@@ -62,15 +129,16 @@ void ChatBotFrame::OnEnter(wxCommandEvent &WXUNUSED(event))
     // delete text in text control
     _userTextCtrl->Clear();
 
-    // send user text to chatbot 
-     _panelDialog->GetChatLogicHandle()->SendMessageToChatbot(std::string(userText.mb_str()));
+    // send user text to chatbot (answered asynchronously)
+    _panelDialog->SendMessageToChatbot(userText);
 }
 
 BEGIN_EVENT_TABLE(ChatBotFrameImagePanel, wxPanel)
 EVT_PAINT(ChatBotFrameImagePanel::paintEvent) // catch paint events
 END_EVENT_TABLE()
 
-ChatBotFrameImagePanel::ChatBotFrameImagePanel(wxFrame *parent) : wxPanel(parent)
+ChatBotFrameImagePanel::ChatBotFrameImagePanel(wxFrame *parent)
+    : wxPanel(parent), _background(this, imgBasePath + "sf_bridge.jpg")
 {
 }
 
@@ -88,17 +156,8 @@ void ChatBotFrameImagePanel::paintNow()
 
 void ChatBotFrameImagePanel::render(wxDC &dc)
 {
-    // load backgroud image from file
-    wxString imgFile = imgBasePath + "sf_bridge.jpg";
-    wxImage image;
-    image.LoadFile(imgFile);
-
-    // rescale image to fit window dimensions
-    wxSize sz = this->GetSize();
-    wxImage imgSmall = image.Rescale(sz.GetWidth(), sz.GetHeight(), wxIMAGE_QUALITY_HIGH);
-    _image = wxBitmap(imgSmall);
-    
-    dc.DrawBitmap(_image, 0, 0, false);
+    // draw cached background image (decoded at startup, rescaled only when the size changes)
+    _background.Draw(dc);
 }
 
 BEGIN_EVENT_TABLE(ChatBotPanelDialog, wxPanel)
@@ -106,14 +165,17 @@ EVT_PAINT(ChatBotPanelDialog::paintEvent) // catch paint events
 END_EVENT_TABLE()
 
 ChatBotPanelDialog::ChatBotPanelDialog(wxWindow *parent, wxWindowID id)
-    : wxScrolledWindow(parent, id)
+    : wxScrolledWindow(parent, id, wxDefaultPosition, wxDefaultSize, wxVSCROLL | wxFULL_REPAINT_ON_RESIZE),
+      _background(this, imgBasePath + "sf_bridge_inner.jpg"), _virtualHeight(dialogItemBorder), _isTyping(false)
 {
-    // sizer will take care of determining the needed scroll size
-    _dialogSizer = new wxBoxSizer(wxVERTICAL);
-    this->SetSizer(_dialogSizer);
+    // the background stays in place while the items scroll, so the window is redrawn instead of
+    // being scrolled physically (double buffered to avoid flicker)
+    this->SetBackgroundStyle(wxBG_STYLE_PAINT);
+    this->EnableScrolling(false, false);
+    this->SetScrollRate(0, 5);
 
-    // allow for PNG images to be handled
-    wxInitAllImageHandlers();
+    // all user dialog items share one decoded avatar
+    _userImage = ImageCache::GetBitmap(imgBasePath + "user.png");
 
     // create chat logic instance on heap
     //_chatLogic = new ChatLogic(); 
@@ -121,49 +183,116 @@ ChatBotPanelDialog::ChatBotPanelDialog(wxWindow *parent, wxWindowID id)
     // Create an exclusive resource, unique pointer by value of ChatLogic class
     _chatLogic = std::make_unique<ChatLogic>();
 
-    // pass pointer to chatbot dialog so answers can be displayed in GUI
-    _chatLogic->SetPanelDialogHandle(this);
-
-    // load answer graph from file
-    _chatLogic->LoadAnswerGraphFromFile(dataPath + "src/answergraph.txt");
-
+    // messages are processed by a worker thread, which passes the chatbot answers back to the GUI thread
+    Bind(EVT_CHATBOT_RESPONSE, &ChatBotPanelDialog::OnChatbotResponse, this);
+    _worker = std::make_unique<ChatWorker>(_chatLogic.get(), [this]() { wxQueueEvent(this, new wxThreadEvent(EVT_CHATBOT_RESPONSE)); });
+
+#ifdef MEMBOT_EMBEDDED_ANSWER_GRAPH
+    // use the answer graph compiled into the executable, nothing is read from disk (the greeting is queued like any other answer)
+    size_t size;
+    const void *image = GetEmbeddedAnswerGraph(size);
+    if (!_chatLogic->LoadAnswerGraphFromImage(image, size))
+        wxLogError("The embedded answer graph could not be loaded.");
+    wxQueueEvent(this, new wxThreadEvent(EVT_CHATBOT_RESPONSE));
+#else
+    // load answer graph from file (the greeting is queued like any other answer)
+    if (!_chatLogic->LoadAnswerGraphFromFile(dataPath + "src/answergraph.txt"))
+        wxLogError("The answer graph %s could not be loaded.", dataPath + "src/answergraph.txt");
+    wxQueueEvent(this, new wxThreadEvent(EVT_CHATBOT_RESPONSE));
+
+    // changes to the answer graph file are picked up with the next message, without a restart
+    _chatLogic->EnableHotReload();
+#endif
 }
 
 ChatBotPanelDialog::~ChatBotPanelDialog()
 {
+    // stop the worker thread before the chat logic and the dialog are gone
+    _worker.reset();
+
     // _chatLogic pointer is created on stack (using make_uinque) and is automatically deleted
     //delete _chatLogic;
 }
 
-void ChatBotPanelDialog::AddDialogItem(wxString text, bool isFromUser)
+const wxBitmap &ChatBotPanelDialog::GetChatbotImage()
 {
-    // add a single dialog element to the sizer
-    ChatBotPanelDialogItem *item = new ChatBotPanelDialogItem(this, text, isFromUser);
-    _dialogSizer->Add(item, 0, wxALL | (isFromUser == true ? wxALIGN_LEFT : wxALIGN_RIGHT), 8);
-    _dialogSizer->Layout();
+    // the chatbot only knows the path of its image, the bitmap is shared through the image cache
+    if (_chatBotImage == nullptr)
+        _chatBotImage = ImageCache::GetBitmap(_chatLogic->GetChatbotImageFilename());
+
+    return *_chatBotImage;
+}
 
+void ChatBotPanelDialog::AddDialogItem(const std::string &text, bool isFromUser)
+{
+    MEMBOT_SCOPED_TIMER(kStageAddDialogItem);
+
+    // wrap the text once, the item keeps its lines and size
+    wxClientDC dc(this);
+    dc.SetFont(this->GetFont());
+    _items.emplace_back(dc, text, isFromUser, isFromUser ? GetUserImage() : GetChatbotImage());
+
+    // append the item below the last one, all other items keep their position
+    _itemTops.push_back(_virtualHeight);
+    _virtualHeight += _items.back().GetSize().GetHeight() + 2 * dialogItemBorder;
+    UpdateVirtualSize();
+}
+
+void ChatBotPanelDialog::UpdateVirtualSize()
+{
     // make scrollbar show up
-    this->FitInside(); // ask the sizer about the needed size
-    this->SetScrollRate(5, 5);
-    this->Layout();
+    int height = _virtualHeight + (_isTyping ? _typingItem->GetSize().GetHeight() + 2 * dialogItemBorder : 0);
+    this->SetVirtualSize(0, height);
 
     // scroll to bottom to show newest element
     int dx, dy;
     this->GetScrollPixelsPerUnit(&dx, &dy);
-    int sy = dy * this->GetScrollLines(wxVERTICAL);
-    this->DoScroll(0, sy);
+    this->Scroll(-1, (height + dy - 1) / dy);
+    this->Refresh(false);
+}
+
+void ChatBotPanelDialog::SetTypingIndicator(bool isTyping)
+{
+    if (isTyping == _isTyping)
+        return;
+
+    if (_typingItem == nullptr)
+    {
+        wxClientDC dc(this);
+        dc.SetFont(this->GetFont());
+        _typingItem = std::make_unique<ChatBotPanelDialogItem>(dc, "...", false, GetChatbotImage());
+    }
+
+    _isTyping = isTyping;
+    UpdateVirtualSize();
+}
+
+void ChatBotPanelDialog::SendMessageToChatbot(const std::string &message)
+{
+    // every message is answered in order, so each bubble of the user gets its answer
+    if (_worker->Submit(message) != 0)
+        SetTypingIndicator(true);
+}
+
+void ChatBotPanelDialog::OnChatbotResponse(wxThreadEvent &evt)
+{
+    // show all answers which have arrived so far
+    ChatWorker::Response response;
+    while (_worker->PopResponse(response))
+        PrintChatbotResponse(response.text);
+
+    SetTypingIndicator(_worker->IsBusy());
 }
 
 void ChatBotPanelDialog::PrintChatbotResponse(std::string response)
 {
-    // convert string into wxString and add dialog element
-    wxString botText(response.c_str(), wxConvUTF8);
-    AddDialogItem(botText, false);
+    // chatbot answers are UTF-8 already
+    AddDialogItem(response, false);
 }
 
 void ChatBotPanelDialog::paintEvent(wxPaintEvent &evt)
 {
-    wxPaintDC dc(this);
+    wxAutoBufferedPaintDC dc(this);
     render(dc);
 }
 
@@ -175,36 +304,87 @@ void ChatBotPanelDialog::paintNow()
 
 void ChatBotPanelDialog::render(wxDC &dc)
 {
-    wxImage image;
-    image.LoadFile(imgBasePath + "sf_bridge_inner.jpg");
-
-    wxSize sz = this->GetSize();
-    wxImage imgSmall = image.Rescale(sz.GetWidth(), sz.GetHeight(), wxIMAGE_QUALITY_HIGH);
+    // draw cached background image (decoded at startup, rescaled only when the size changes)
+    _background.Draw(dc);
 
-    _image = wxBitmap(imgSmall);
-    dc.DrawBitmap(_image, 0, 0, false);
+    // determine the visible part of the virtual area
+    int dx, dy, vx, vy;
+    this->GetScrollPixelsPerUnit(&dx, &dy);
+    this->GetViewStart(&vx, &vy);
+    int viewTop = vy * dy;
+    wxSize sz = this->GetClientSize();
+
+    // draw only the items which intersect the visible part, starting with the last item above its top
+    auto it = std::upper_bound(_itemTops.begin(), _itemTops.end(), viewTop);
+    size_t first = it == _itemTops.begin() ? 0 : (it - _itemTops.begin()) - 1;
+    for (size_t i = first; i < _items.size() && _itemTops[i] < viewTop + sz.GetHeight(); ++i)
+    {
+        const ChatBotPanelDialogItem &item = _items[i];
+        int x = item.IsFromUser() ? dialogItemBorder : sz.GetWidth() - item.GetSize().GetWidth() - dialogItemBorder;
+        item.Draw(dc, x, _itemTops[i] + dialogItemBorder - viewTop, item.IsFromUser() ? GetUserImage() : GetChatbotImage());
+    }
+
+    // typing indicator below the last item
+    if (_isTyping)
+    {
+        int x = sz.GetWidth() - _typingItem->GetSize().GetWidth() - dialogItemBorder;
+        _typingItem->Draw(dc, x, _virtualHeight + dialogItemBorder - viewTop, GetChatbotImage());
+    }
 }
 
-ChatBotPanelDialogItem::ChatBotPanelDialogItem(wxPanel *parent, wxString text, bool isFromUser)
-    : wxPanel(parent, -1, wxPoint(-1, -1), wxSize(-1, -1), wxBORDER_NONE)
+ChatBotPanelDialogItem::ChatBotPanelDialogItem(wxDC &dc, const std::string &text, bool isFromUser, const wxBitmap &image)
+    : _isFromUser(isFromUser)
 {
-    // retrieve image from chatbot
-    wxBitmap *bitmap = isFromUser == true ? nullptr : ((ChatBotPanelDialog*)parent)->GetChatLogicHandle()->GetImageFromChatbot(); 
-
-    // create image and text
-    _chatBotImg = new wxStaticBitmap(this, wxID_ANY, (isFromUser ? wxBitmap(imgBasePath + "user.png", wxBITMAP_TYPE_PNG) : *bitmap), wxPoint(-1, -1), wxSize(-1, -1));
-    _chatBotTxt = new wxStaticText(this, wxID_ANY, text, wxPoint(-1, -1), wxSize(150, -1), wxALIGN_CENTRE | wxBORDER_NONE);
-    _chatBotTxt->SetForegroundColour(isFromUser == true ? wxColor(*wxBLACK) : wxColor(*wxWHITE));
-
-    // create sizer and add elements
-    wxBoxSizer *horzBoxSizer = new wxBoxSizer(wxHORIZONTAL);
-    horzBoxSizer->Add(_chatBotTxt, 8, wxEXPAND | wxALL, 1);
-    horzBoxSizer->Add(_chatBotImg, 2, wxEXPAND | wxALL, 1);
-    this->SetSizer(horzBoxSizer);
-
-    // wrap text after 150 pixels
-    _chatBotTxt->Wrap(150);
+    // wrap text after 150 pixels (word by word, longer words get a line of their own)
+    _lineHeight = dc.GetCharHeight();
+    std::string line;
+    size_t pos = 0;
+    while (pos <= text.size())
+    {
+        size_t end = text.find_first_of(" \n", pos);
+        if (end == std::string::npos)
+            end = text.size();
+
+        std::string candidate = line.empty() ? text.substr(pos, end - pos) : line + " " + text.substr(pos, end - pos);
+        if (!line.empty() && dc.GetTextExtent(wxString::FromUTF8(candidate.c_str())).GetWidth() > dialogTextWidth)
+        {
+            _lines.push_back(wxString::FromUTF8(line.c_str()));
+            line = text.substr(pos, end - pos);
+        }
+        else
+        {
+            line = candidate;
+        }
+
+        if (end == text.size() || text[end] == '\n')
+        {
+            _lines.push_back(wxString::FromUTF8(line.c_str()));
+            line.clear();
+        }
+        pos = end + 1;
+    }
+
+    for (const wxString &l : _lines)
+        _lineWidths.push_back(dc.GetTextExtent(l).GetWidth());
+
+    int textHeight = _lineHeight * int(_lines.size());
+    _size = wxSize(dialogTextWidth + image.GetWidth() + 4 * dialogItemPadding,
+                   std::max(textHeight, image.GetHeight()) + 2 * dialogItemPadding);
+}
 
+void ChatBotPanelDialogItem::Draw(wxDC &dc, int x, int y, const wxBitmap &image) const
+{
     // set background color
-    this->SetBackgroundColour((isFromUser == true ? wxT("YELLOW") : wxT("BLUE")));
+    dc.SetPen(*wxTRANSPARENT_PEN);
+    dc.SetBrush(wxBrush(_isFromUser == true ? wxColour(wxT("YELLOW")) : wxColour(wxT("BLUE"))));
+    dc.DrawRectangle(x, y, _size.GetWidth(), _size.GetHeight());
+
+    // draw centred text lines, vertically centred next to the avatar
+    dc.SetTextForeground(_isFromUser == true ? wxColor(*wxBLACK) : wxColor(*wxWHITE));
+    int textTop = y + (_size.GetHeight() - _lineHeight * int(_lines.size())) / 2;
+    for (size_t i = 0; i < _lines.size(); ++i)
+        dc.DrawText(_lines[i], x + dialogItemPadding + (dialogTextWidth - _lineWidths[i]) / 2, textTop + int(i) * _lineHeight);
+
+    // draw avatar
+    dc.DrawBitmap(image, x + dialogTextWidth + 3 * dialogItemPadding, y + (_size.GetHeight() - image.GetHeight()) / 2, true);
 }
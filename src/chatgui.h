@@ -2,21 +2,93 @@
 #define CHATGUI_H_
 
 #include <wx/wx.h>
+#include <wx/timer.h>
 #include <memory>
+#include <string>
+#include <vector>
 
-class ChatLogic; // forward declaration
+class ChatLogic;  // forward declaration
+class ChatWorker; // forward declaration
 
-// middle part of the window containing the dialog between user and chatbot
+// posted by the chat worker thread whenever it has finished a message
+wxDECLARE_EVENT(EVT_CHATBOT_RESPONSE, wxThreadEvent);
+
+// background image of a window, decoded once and rescaled only when the window size has changed
+// (while the window is being resized, a fast rescale is drawn until the size is stable again)
+class BackgroundBitmap
+{
+private:
+    // data handles (not owned)
+    wxWindow *_owner;
+
+    // proprietary members
+    wxImage _image;      // decoded image in original size
+    wxBitmap _bitmap;    // image rescaled to _bitmapSize
+    wxSize _bitmapSize;
+    bool _isHighQuality; // whether _bitmap has been rescaled with high quality
+    wxTimer _resizeTimer;
+
+    // events
+    void OnSize(wxSizeEvent &evt);
+    void OnResizeTimer(wxTimerEvent &evt);
+
+public:
+    // constructor / destructor
+    BackgroundBitmap(wxWindow *owner, const std::string &filename);
+
+    // proprietary functions
+    void Draw(wxDC &dc); // never reads from disk
+};
+
+// dialog item shown in ChatBotPanelDialog. Items are no windows but are drawn by the dialog,
+// their text is wrapped once on creation so that painting and layout never measure it again.
+class ChatBotPanelDialogItem
+{
+private:
+    // proprietary members
+    std::vector<wxString> _lines; // text wrapped after 150 pixels
+    std::vector<int> _lineWidths; // width of each line in pixels
+    int _lineHeight;
+    bool _isFromUser;
+    wxSize _size;                 // text and avatar including padding
+
+public:
+    // constructor / destructor
+    ChatBotPanelDialogItem(wxDC &dc, const std::string &text, bool isFromUser, const wxBitmap &image);
+
+    // getter / setter
+    const wxSize &GetSize() const { return _size; }
+    bool IsFromUser() const { return _isFromUser; }
+
+    // proprietary functions
+    void Draw(wxDC &dc, int x, int y, const wxBitmap &image) const;
+};
+
+// middle part of the window containing the dialog between user and chatbot. Only the items
+// in the visible part are drawn, and new items are appended without laying out the others.
 class ChatBotPanelDialog : public wxScrolledWindow
 {
 private:
     // control elements
-    wxBoxSizer *_dialogSizer;
-    wxBitmap _image;
+    BackgroundBitmap _background;
+    std::shared_ptr<const wxBitmap> _userImage;    // avatar of the user, shared through the image cache
+    std::shared_ptr<const wxBitmap> _chatBotImage; // avatar of the chatbot, requested on first use
+
+    // dialog items and their vertical position in the virtual area
+    std::vector<ChatBotPanelDialogItem> _items;
+    std::vector<int> _itemTops;
+    int _virtualHeight;
+    std::unique_ptr<ChatBotPanelDialogItem> _typingItem; // shown below the last item while the chatbot is busy
+    bool _isTyping;
 
     // Resource Acquisition Is Initialization (RAII) using smart pointers
     // std::make_unique() (>= C++14 ONLY), unique_ptr() (>= C++11)
     std::unique_ptr<ChatLogic> _chatLogic;
+    std::unique_ptr<ChatWorker> _worker; // the only thread using _chatLogic once the graph is loaded
+
+    // proprietary functions
+    void UpdateVirtualSize(); // scrolls to the bottom
+    void SetTypingIndicator(bool isTyping);
 
 public:
     // constructor / destructor
@@ -25,32 +97,23 @@ public:
 
     // getter / setter - Use .get() function to retrieve a raw pointer to the object
     ChatLogic *GetChatLogicHandle() { return _chatLogic.get(); }
+    const wxBitmap &GetUserImage() const { return *_userImage; }
+    const wxBitmap &GetChatbotImage();
 
     // events
     void paintEvent(wxPaintEvent &evt);
     void paintNow();
     void render(wxDC &dc);
+    void OnChatbotResponse(wxThreadEvent &evt);
 
     // proprietary functions
-    void AddDialogItem(wxString text, bool isFromUser = true);
+    void AddDialogItem(const std::string &text, bool isFromUser = true); // text is UTF-8
     void PrintChatbotResponse(std::string response);
+    void SendMessageToChatbot(const std::string &message); // returns immediately, every message is answered in order
 
     DECLARE_EVENT_TABLE()
 };
 
-// dialog item shown in ChatBotPanelDialog
-class ChatBotPanelDialogItem : public wxPanel
-{
-private:
-    // control elements
-    wxStaticBitmap *_chatBotImg;
-    wxStaticText *_chatBotTxt;
-
-public:
-    // constructor / destructor
-    ChatBotPanelDialogItem(wxPanel *parent, wxString text, bool isFromUser);
-};
-
 // frame containing all control elements
 class ChatBotFrame : public wxFrame
 {
@@ -71,7 +134,7 @@ public:
 class ChatBotFrameImagePanel : public wxPanel
 {
     // control elements
-    wxBitmap _image;
+    BackgroundBitmap _background;
 
 public:
     // constructor / desctructor
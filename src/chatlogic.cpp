@@ -1,11 +1,11 @@
-#include <fstream>
-#include <sstream>
-#include <iostream>
+#include <atomic>
 #include <vector>
-#include <iterator>
-#include <tuple>
-#include <algorithm>
 
+#include "instrumentation.h"
+#include "log.h"
+#include "graphloader.h"
+#include "graphwatcher.h"
+#include "answergraph.h"
 #include "graphedge.h"
 #include "graphnode.h"
 #include "chatbot.h"
@@ -14,6 +14,11 @@
 
 ChatLogic::ChatLogic()
 {
+    _hasRandomSeed = false;
+    _randomSeed = 0;
+    _matchWords = false;
+    _responseCacheCapacity = 0;
+
     // create instance of chatbot
     //_chatBot = new ChatBot("../images/chatbot.png");
 
@@ -23,6 +28,9 @@ ChatLogic::ChatLogic()
 
 ChatLogic::~ChatLogic()
 {
+    // the watcher thread publishes into this instance
+    DisableHotReload();
+
     // delete chatbot instance
     // std::cout<< "Delete chatBot instance in ChatLogic Destructor" << std::endl;
     // delete _chatBot;
@@ -40,187 +48,139 @@ ChatLogic::~ChatLogic()
     // }
 }
 
-template <typename T>
-void ChatLogic::AddAllTokensToElement(std::string tokenID, tokenlist &tokens, T &element)
+bool ChatLogic::LoadAnswerGraphFromFile(std::string filename)
 {
-    // find all occurences for current node
-    auto token = tokens.begin();
-    while (true)
+    // a graph with missing nodes or without a root node is not used
+    std::unique_ptr<AnswerGraph> graph = LoadAnswerGraph(filename);
+    if (graph == nullptr)
     {
-        token = std::find_if(token, tokens.end(), [&tokenID](const std::pair<std::string, std::string> &pair) { return pair.first == tokenID;; });
-        if (token != tokens.end())
-        {
-            element.AddToken(token->second); // add new keyword to edge
-            token++;                         // increment iterator to next element
-        }
-        else
-        {
-            break; // quit infinite while-loop
-        }
+        MEMBOT_LOG_ERROR("Error: answer graph is not used!");
+        return false;
     }
+
+    StartConversation(std::move(graph));
+    _graphFilename = filename;
+    return true;
 }
 
-void ChatLogic::LoadAnswerGraphFromFile(std::string filename)
+bool ChatLogic::LoadAnswerGraphFromImage(const void *data, size_t size)
 {
-    // load file with answer graph elements
-    std::ifstream file(filename);
-
-    // check for file availability and process it line by line
-    if (file)
+    // nothing is read or parsed, the tables of the image are used in place
+    std::unique_ptr<AnswerGraph> graph = LoadAnswerGraphImage(data, size);
+    if (graph == nullptr)
     {
-        // loop over all lines in the file
-        std::string lineStr;
-        while (getline(file, lineStr))
-        {
-            // extract all tokens from current line
-            tokenlist tokens;
-            while (lineStr.size() > 0)
-            {
-                // extract next token
-                int posTokenFront = lineStr.find("<");
-                int posTokenBack = lineStr.find(">");
-                if (posTokenFront < 0 || posTokenBack < 0)
-                    break; // quit loop if no complete token has been found
-                std::string tokenStr = lineStr.substr(posTokenFront + 1, posTokenBack - 1);
-
-                // extract token type and info
-                int posTokenInfo = tokenStr.find(":");
-                if (posTokenInfo != std::string::npos)
-                {
-                    std::string tokenType = tokenStr.substr(0, posTokenInfo);
-                    std::string tokenInfo = tokenStr.substr(posTokenInfo + 1, tokenStr.size() - 1);
-
-                    // add token to vector
-                    tokens.push_back(std::make_pair(tokenType, tokenInfo));
-                }
-
-                // remove token from current line
-                lineStr = lineStr.substr(posTokenBack + 1, lineStr.size());
-            }
-
-            // process tokens for current line
-            auto type = std::find_if(tokens.begin(), tokens.end(), [](const std::pair<std::string, std::string> &pair) { return pair.first == "TYPE"; });
-            if (type != tokens.end())
-            {
-                // check for id
-                auto idToken = std::find_if(tokens.begin(), tokens.end(), [](const std::pair<std::string, std::string> &pair) { return pair.first == "ID"; });
-                if (idToken != tokens.end())
-                {
-                    // extract id from token
-                    int id = std::stoi(idToken->second);
-
-                    // node-based processing
-                    if (type->second == "NODE")
-                    {
-                        // check if node with this ID exists already
-                        auto newNode = std::find_if(_nodes.begin(), _nodes.end(), [&id](std::unique_ptr<GraphNode> &node) { return node->GetID() == id; });
-
-                        // create new element if ID does not yet exist
-                        if (newNode == _nodes.end())
-                        {
-                            _nodes.emplace_back(std::make_unique<GraphNode>(id));
-                            newNode = _nodes.end() - 1; // get iterator to last element
-
-                            // add all answers to current node
-                            AddAllTokensToElement("ANSWER", tokens, **newNode);
-                        }
-                    }
-
-                    // edge-based processing
-                    if (type->second == "EDGE")
-                    {
-                        // find tokens for incoming (parent) and outgoing (child) node
-                        auto parentToken = std::find_if(tokens.begin(), tokens.end(), [](const std::pair<std::string, std::string> &pair) { return pair.first == "PARENT"; });
-                        auto childToken = std::find_if(tokens.begin(), tokens.end(), [](const std::pair<std::string, std::string> &pair) { return pair.first == "CHILD"; });
-
-                        if (parentToken != tokens.end() && childToken != tokens.end())
-                        {
-                            // get iterator on incoming and outgoing node via ID search
-                            auto parentNode = std::find_if(_nodes.begin(), _nodes.end(), [&parentToken](std::unique_ptr<GraphNode> &node) { return node->GetID() == std::stoi(parentToken->second); });
-                            auto childNode = std::find_if(_nodes.begin(), _nodes.end(), [&childToken](std::unique_ptr<GraphNode> &node) { return node->GetID() == std::stoi(childToken->second); });
-
-                            // create new edge (cannot make this a unique_ptr as it cannot be copied)
-                            GraphEdge *edge = new GraphEdge(id);
-                            edge->SetChildNode((*childNode).get());
-                            edge->SetParentNode((*parentNode).get());
-                           // _edges.push_back(edge); 
-
-                            // find all keywords for current node
-                            AddAllTokensToElement("KEYWORD", tokens, *edge);
-
-                            // store reference in child node and parent node
-                            (*childNode)->AddEdgeToParentNode(edge);
-                            (*parentNode)->AddEdgeToChildNode(edge);
-                        }
-                    }
-                }
-                else
-                {
-                    std::cout << "Error: ID missing. Line is ignored!" << std::endl;
-                }
-            }
-        } // eof loop over all lines in the file
-
-        file.close();
-
-    } // eof check for file availability
-    else
-    {
-        std::cout << "File could not be opened!" << std::endl;
-        return;
+        MEMBOT_LOG_ERROR("Error: answer graph is not used!");
+        return false;
     }
 
+    // there is no file to watch
+    StartConversation(std::move(graph));
+    return true;
+}
+
+void ChatLogic::StartConversation(std::unique_ptr<AnswerGraph> graph)
+{
+    // the word index is built once, before the graph becomes immutable
+    if (_matchWords)
+        graph->EnableWordMatching();
+    graph->EnableResponseCache(_responseCacheCapacity);
+    _graph = std::move(graph);
+    _graphFilename.clear();
+
+    // a reload of the previous file must not replace the new graph
+    DisableHotReload();
+    std::atomic_store(&_reloadedGraph, std::shared_ptr<const AnswerGraph>());
+
     // identify root node
-    GraphNode *rootNode = nullptr;
- 
-    for(auto const &node_ptr : _nodes ) {
-        // search for nodes which have no incoming edges
-        if (node_ptr->GetNumberOfParents() == 0) {
-            if (rootNode == nullptr) {                
-                rootNode = node_ptr.get();// assign current node to root
-            }
-            else {
-                std::cout << "ERROR : Multiple root nodes detected" << std::endl;
-            }
-        }
-    }
+    const GraphNode *rootNode = _graph->GetRootNode();
+
+    // create chatbot on heap, it only keeps the index of its current node in the immutable graph
+    _chatBot = std::make_unique<ChatBot>("../images/chatbot.png");
+    _chatBot->SetChatLogicHandle(this);
+    _chatBot->SetAnswerGraph(_graph.get());
+    if (_hasRandomSeed)
+        _chatBot->SetRandomSeed(_randomSeed);
+
+    // start conversation at graph root node
+    _chatBot->SetRootNode(rootNode);
+    _chatBot->SetCurrentNode(rootNode);
+}
 
-    // create a unique_ptr on stack to ChatBot object on heap
-    std::unique_ptr chatbot = std::make_unique<ChatBot>("../images/chatbot.png");
+bool ChatLogic::EnableHotReload(std::chrono::milliseconds interval)
+{
+    if (_graph == nullptr || _graphFilename.empty())
+        return false;
+
+    // the graph is built on the watcher thread, only the finished graph is handed over
+    bool matchWords = _matchWords;
+    size_t cacheCapacity = _responseCacheCapacity;
+    _watcher = std::make_unique<AnswerGraphWatcher>(_graphFilename, interval, [this, matchWords, cacheCapacity](std::unique_ptr<AnswerGraph> graph) {
+        if (matchWords)
+            graph->EnableWordMatching();
+        graph->EnableResponseCache(cacheCapacity);
+        std::atomic_store(&_reloadedGraph, std::shared_ptr<const AnswerGraph>(std::move(graph)));
+    });
+    return true;
+}
 
-    // create a ChatBot object on stack using move semantics 
-    ChatBot chatBot = std::move(*chatbot);  
+void ChatLogic::DisableHotReload()
+{
+    _watcher.reset();
+}
+
+void ChatLogic::SwitchToReloadedGraph()
+{
+    if (std::atomic_load(&_reloadedGraph) == nullptr)
+        return;
+
+    // the chatbot continues at the node with the same ID, the previous graph is freed once it is no longer used
+    std::shared_ptr<const AnswerGraph> graph = std::atomic_exchange(&_reloadedGraph, std::shared_ptr<const AnswerGraph>());
+    _chatBot->ChangeAnswerGraph(graph.get());
+    _graph = std::move(graph);
+    MEMBOT_LOG_INFO("Switched to reloaded answer graph " << _graphFilename);
+}
 
-    // set non-owning reference to ChatBot object on stack
-    _chatBot = &chatBot;
+void ChatLogic::SetResponseHandler(std::function<void(std::string_view)> responseHandler)
+{
+    _responseHandler = std::move(responseHandler);
+}
 
-    chatBot.SetChatLogicHandle(this);
-    // add chatbot to graph root node
-    chatBot.SetRootNode(rootNode);
-    rootNode->MoveChatbotHere(std::move(chatBot)); //passing r-value reference
+void ChatLogic::SetRandomSeed(uint64_t seed)
+{
+    _hasRandomSeed = true;
+    _randomSeed = seed;
 }
 
-void ChatLogic::SetPanelDialogHandle(ChatBotPanelDialog *panelDialog)
+void ChatLogic::SetWordMatching(bool enabled)
 {
-    _panelDialog = panelDialog;
+    _matchWords = enabled;
 }
 
-void ChatLogic::SetChatbotHandle(ChatBot *chatbot)
+void ChatLogic::SetResponseCache(size_t capacity)
 {
-    _chatBot = chatbot;
+    _responseCacheCapacity = capacity;
 }
 
-void ChatLogic::SendMessageToChatbot(std::string message)
+void ChatLogic::SendMessageToChatbot(const std::string &message)
 {
+    MEMBOT_SCOPED_TIMER(kStageSendMessage);
+
+    // no chatbot exists if the answer graph could not be loaded
+    if (_chatBot == nullptr)
+        return;
+
+    SwitchToReloadedGraph();
+
     _chatBot->ReceiveMessageFromUser(message);
 }
 
-void ChatLogic::SendMessageToUser(std::string message)
+void ChatLogic::SendMessageToUser(std::string_view message)
 {
-    _panelDialog->PrintChatbotResponse(message);
+    if (_responseHandler)
+        _responseHandler(message);
 }
 
-wxBitmap *ChatLogic::GetImageFromChatbot()
+std::string ChatLogic::GetChatbotImageFilename() const
 {
-    return _chatBot->GetImageHandle();
+    return _chatBot != nullptr ? _chatBot->GetImageFilename() : std::string();
 }
@@ -1,14 +1,21 @@
 #ifndef CHATLOGIC_H_
 #define CHATLOGIC_H_
 
+#include <chrono>
+#include <functional>
 #include <vector>
 #include <string>
-#include "chatgui.h"
+#include <string_view>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
 
 // forward declarations
 class ChatBot;
 class GraphEdge;
 class GraphNode;
+class AnswerGraph;
+class AnswerGraphWatcher;
 
 class ChatLogic
 {
@@ -18,19 +25,36 @@ private:
     //std::vector<GraphEdge *> _edges;
 
     // Create instances of GraphNode objects that are exclusively owned by ChatLogic class 
-    std::vector<std::unique_ptr<GraphNode>> _nodes;
+    //std::vector<std::unique_ptr<GraphNode>> _nodes;
+
+    // answer graph with all nodes and edges in flat arrays (immutable, may be shared)
+    std::shared_ptr<const AnswerGraph> _graph;
     
-    // data handles (not owned)
-    GraphNode *_currentNode;
-    ChatBot *_chatBot;
-    ChatBotPanelDialog *_panelDialog;
+    // chatbot that walks the answer graph, exclusively owned by ChatLogic
+    std::unique_ptr<ChatBot> _chatBot;
+
+    // receives the chatbot answers, e.g. to show them in the GUI or to print them to a terminal
+    std::function<void(std::string_view)> _responseHandler;
+
+    // seed for the answer selection of the chatbot (random if not set)
+    bool _hasRandomSeed;
+    uint64_t _randomSeed;
+
+    // match keywords against the words of a message instead of the whole message
+    bool _matchWords;
+
+    // routing decisions cached per graph (0 disables the cache), a reloaded graph starts empty
+    size_t _responseCacheCapacity;
 
-    // proprietary type definitions
-    typedef std::vector<std::pair<std::string, std::string>> tokenlist;
+    // hot reload: the watcher publishes a new graph with std::atomic_store, the thread sending
+    // messages picks it up before the next message, so neither of them ever waits for the other
+    std::string _graphFilename;
+    std::shared_ptr<const AnswerGraph> _reloadedGraph;
+    std::unique_ptr<AnswerGraphWatcher> _watcher;
 
     // proprietary functions
-    template <typename T>
-    void AddAllTokensToElement(std::string tokenID, tokenlist &tokens, T &element);
+    void StartConversation(std::unique_ptr<AnswerGraph> graph);
+    void SwitchToReloadedGraph();
 
 public:
     // constructor / destructor
@@ -38,14 +62,19 @@ public:
     ~ChatLogic();
 
     // getter / setter
-    void SetPanelDialogHandle(ChatBotPanelDialog *panelDialog);
-    void SetChatbotHandle(ChatBot *chatbot);
+    void SetResponseHandler(std::function<void(std::string_view)> responseHandler); // the answer is only valid during the call
+    void SetRandomSeed(uint64_t seed); // for reproducible conversations, must be set before loading the graph
+    void SetWordMatching(bool enabled); // must be set before loading the graph
+    void SetResponseCache(size_t capacity); // must be set before loading the graph, 0 disables the cache
 
     // proprietary functions
-    void LoadAnswerGraphFromFile(std::string filename);
-    void SendMessageToChatbot(std::string message);
-    void SendMessageToUser(std::string message);
-    wxBitmap *GetImageFromChatbot();
+    bool LoadAnswerGraphFromFile(std::string filename); // text or binary format, returns false if the graph is not used
+    bool LoadAnswerGraphFromImage(const void *data, size_t size); // binary format used in place (e.g. the embedded graph), which must outlive the chat logic
+    bool EnableHotReload(std::chrono::milliseconds interval = std::chrono::milliseconds(1000)); // watches the loaded file, returns false if there is none
+    void DisableHotReload();
+    void SendMessageToChatbot(const std::string &message);
+    void SendMessageToUser(std::string_view message);
+    std::string GetChatbotImageFilename() const;
 };
 
 #endif /* CHATLOGIC_H_ */
\ No newline at end of file
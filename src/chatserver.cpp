@@ -0,0 +1,352 @@
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "instrumentation.h"
+#include "log.h"
+#include "chatserver.h"
+
+namespace
+{
+const int kMaxEvents = 256;       // events handled per epoll_wait
+const size_t kReadSize = 16384;   // bytes received per readiness event, which bounds the input buffer
+const size_t kFrameHeaderSize = 4; // big-endian length
+
+uint32_t DecodeLength(const char *header)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(header);
+    return (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | uint32_t(bytes[3]);
+}
+} // namespace
+
+ChatServer::ChatServer(ConversationEngine &engine, size_t numReactors)
+    : _engine(&engine), _numReactors(numReactors), _port(0), _numConnections(0)
+{
+    if (_numReactors == 0)
+        _numReactors = std::thread::hardware_concurrency();
+    if (_numReactors == 0)
+        _numReactors = 1;
+}
+
+ChatServer::~ChatServer()
+{
+    Stop();
+}
+
+void ChatServer::AppendFrame(std::string &buffer, std::string_view message)
+{
+    uint32_t length = uint32_t(message.size());
+    char header[kFrameHeaderSize] = {char(length >> 24), char(length >> 16), char(length >> 8), char(length)};
+    buffer.append(header, kFrameHeaderSize);
+    buffer.append(message.data(), message.size());
+}
+
+int ChatServer::CreateListenSocket(uint16_t port)
+{
+    int fd = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        MEMBOT_LOG_ERROR("Error: socket could not be created: " << std::strerror(errno));
+        return -1;
+    }
+
+    // every reactor binds the same port, the kernel balances the connections between the sockets;
+    // the socket accepts IPv4 connections as well
+    int one = 1, zero = 0;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0)
+    {
+        MEMBOT_LOG_ERROR("Error: SO_REUSEPORT is not available: " << std::strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    sockaddr_in6 address{};
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_any;
+    address.sin6_port = htons(port);
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || listen(fd, SOMAXCONN) < 0)
+    {
+        MEMBOT_LOG_ERROR("Error: port " << port << " could not be bound: " << std::strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool ChatServer::Start(uint16_t port)
+{
+    if (!_reactors.empty())
+        return false;
+
+    for (size_t i = 0; i < _numReactors; ++i)
+    {
+        auto reactor = std::make_unique<Reactor>();
+        reactor->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        reactor->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        reactor->listenFd = CreateListenSocket(port);
+
+        bool isReady = reactor->epollFd >= 0 && reactor->wakeFd >= 0 && reactor->listenFd >= 0;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.ptr = &reactor->listenFd;
+        isReady = isReady && epoll_ctl(reactor->epollFd, EPOLL_CTL_ADD, reactor->listenFd, &event) == 0;
+        event.data.ptr = &reactor->wakeFd;
+        isReady = isReady && epoll_ctl(reactor->epollFd, EPOLL_CTL_ADD, reactor->wakeFd, &event) == 0;
+        if (!isReady)
+        {
+            for (int fd : {reactor->epollFd, reactor->wakeFd, reactor->listenFd})
+            {
+                if (fd >= 0)
+                    close(fd);
+            }
+            Stop();
+            return false;
+        }
+        reactor->readBuffer.resize(kReadSize);
+        _reactors.push_back(std::move(reactor));
+
+        // with port 0 the first socket picks the port, all others bind the same one
+        if (i == 0)
+        {
+            sockaddr_in6 address{};
+            socklen_t length = sizeof(address);
+            getsockname(_reactors[0]->listenFd, reinterpret_cast<sockaddr *>(&address), &length);
+            port = _port = ntohs(address.sin6_port);
+        }
+    }
+
+    for (std::unique_ptr<Reactor> &reactor : _reactors)
+        reactor->thread = std::thread(&ChatServer::Run, this, std::ref(*reactor));
+    return true;
+}
+
+void ChatServer::Stop()
+{
+    for (std::unique_ptr<Reactor> &reactor : _reactors)
+    {
+        uint64_t one = 1;
+        if (!reactor->thread.joinable())
+            continue;
+        while (write(reactor->wakeFd, &one, sizeof(one)) < 0 && errno == EINTR)
+            ;
+        reactor->thread.join();
+    }
+
+    // the reactor threads have finished, their connections can be closed from here
+    for (std::unique_ptr<Reactor> &reactor : _reactors)
+    {
+        while (!reactor->connections.empty())
+            Close(*reactor, *reactor->connections.begin()->second);
+        close(reactor->listenFd);
+        close(reactor->wakeFd);
+        close(reactor->epollFd);
+    }
+    _reactors.clear();
+}
+
+void ChatServer::Run(Reactor &reactor)
+{
+    std::vector<epoll_event> events(kMaxEvents);
+    while (true)
+    {
+        int numEvents = epoll_wait(reactor.epollFd, events.data(), kMaxEvents, -1);
+        if (numEvents < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            MEMBOT_LOG_ERROR("Error: epoll_wait failed: " << std::strerror(errno));
+            return;
+        }
+
+        for (int i = 0; i < numEvents; ++i)
+        {
+            void *handle = events[i].data.ptr;
+            if (handle == &reactor.wakeFd)
+                return;
+            else if (handle == &reactor.listenFd)
+                Accept(reactor);
+            else
+                HandleEvents(reactor, *static_cast<Connection *>(handle), events[i].events);
+        }
+    }
+}
+
+void ChatServer::Accept(Reactor &reactor)
+{
+    while (true)
+    {
+        int fd = accept4(reactor.listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                MEMBOT_LOG_WARNING("Warning: connection could not be accepted: " << std::strerror(errno));
+            return;
+        }
+
+        // answers are small and must not wait for more data
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        connection->outputOffset = 0;
+        connection->events = EPOLLIN;
+        connection->session = _engine->CreateSession(&reactor.answer);
+        if (connection->session == ConversationEngine::kInvalidSession)
+        {
+            close(fd);
+            continue;
+        }
+
+        epoll_event event{};
+        event.events = connection->events;
+        event.data.ptr = connection.get();
+        if (epoll_ctl(reactor.epollFd, EPOLL_CTL_ADD, fd, &event) < 0)
+        {
+            MEMBOT_LOG_WARNING("Warning: connection could not be registered: " << std::strerror(errno));
+            _engine->EndSession(connection->session);
+            close(fd);
+            continue;
+        }
+
+        Connection &added = *connection;
+        reactor.connections.emplace(connection.get(), std::move(connection));
+        _numConnections.fetch_add(1, std::memory_order_relaxed);
+
+        // the greeting is the first frame of every connection
+        AppendFrame(added.output, reactor.answer);
+        if (Flush(added))
+            UpdateEvents(reactor, added);
+        else
+            Close(reactor, added);
+    }
+}
+
+void ChatServer::HandleEvents(Reactor &reactor, Connection &connection, uint32_t events)
+{
+    // a hang-up or an error is detected by the read
+    bool isOpen = true;
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+        isOpen = Read(reactor, connection);
+    if (isOpen && (events & EPOLLOUT))
+        isOpen = Flush(connection);
+
+    // frames left over while the output was full are answered once it has drained
+    if (isOpen)
+        isOpen = Process(reactor, connection) && Flush(connection);
+
+    if (isOpen)
+        UpdateEvents(reactor, connection);
+    else
+        Close(reactor, connection);
+}
+
+bool ChatServer::Read(Reactor &reactor, Connection &connection)
+{
+    while (true)
+    {
+        ssize_t numRead = recv(connection.fd, reactor.readBuffer.data(), reactor.readBuffer.size(), 0);
+        if (numRead > 0)
+        {
+            connection.input.append(reactor.readBuffer.data(), size_t(numRead));
+            return true;
+        }
+        if (numRead == 0)
+            return false; // closed by the client
+        if (errno == EINTR)
+            continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+bool ChatServer::Process(Reactor &reactor, Connection &connection)
+{
+    size_t offset = 0;
+    while (connection.input.size() - offset >= kFrameHeaderSize && connection.output.size() - connection.outputOffset <= kMaxPendingOutput)
+    {
+        uint32_t length = DecodeLength(connection.input.data() + offset);
+        if (length > kMaxFrameLength)
+        {
+            MEMBOT_LOG_WARNING("Warning: frame of " << length << " bytes, connection is closed");
+            return false;
+        }
+        if (connection.input.size() - offset - kFrameHeaderSize < length)
+            break;
+
+        {
+            MEMBOT_SCOPED_TIMER(kStageServerTurn);
+            std::string_view message(connection.input.data() + offset + kFrameHeaderSize, length);
+            if (!_engine->Respond(connection.session, message, reactor.answer))
+                return false;
+            AppendFrame(connection.output, reactor.answer);
+        }
+        offset += kFrameHeaderSize + length;
+    }
+
+    // an incomplete frame is kept for the next read
+    connection.input.erase(0, offset);
+    return true;
+}
+
+bool ChatServer::Flush(Connection &connection)
+{
+    while (connection.outputOffset < connection.output.size())
+    {
+        ssize_t numWritten = send(connection.fd, connection.output.data() + connection.outputOffset, connection.output.size() - connection.outputOffset,
+                                  MSG_NOSIGNAL);
+        if (numWritten > 0)
+            connection.outputOffset += size_t(numWritten);
+        else if (numWritten < 0 && errno == EINTR)
+            continue;
+        else if (numWritten < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        else
+            return false;
+    }
+
+    // the buffer keeps its capacity, only sent bytes are dropped
+    if (connection.outputOffset == connection.output.size())
+    {
+        connection.output.clear();
+        connection.outputOffset = 0;
+    }
+    else if (connection.outputOffset > kMaxPendingOutput)
+    {
+        connection.output.erase(0, connection.outputOffset);
+        connection.outputOffset = 0;
+    }
+    return true;
+}
+
+void ChatServer::UpdateEvents(Reactor &reactor, Connection &connection)
+{
+    // a client that does not read its answers is not read from either
+    size_t pending = connection.output.size() - connection.outputOffset;
+    uint32_t events = (pending <= kMaxPendingOutput ? uint32_t(EPOLLIN) : 0) | (pending > 0 ? uint32_t(EPOLLOUT) : 0);
+    if (events == connection.events)
+        return;
+
+    epoll_event event{};
+    event.events = events;
+    event.data.ptr = &connection;
+    if (epoll_ctl(reactor.epollFd, EPOLL_CTL_MOD, connection.fd, &event) == 0)
+        connection.events = events;
+}
+
+void ChatServer::Close(Reactor &reactor, Connection &connection)
+{
+    epoll_ctl(reactor.epollFd, EPOLL_CTL_DEL, connection.fd, nullptr);
+    close(connection.fd);
+    _engine->EndSession(connection.session);
+    _numConnections.fetch_sub(1, std::memory_order_relaxed);
+    reactor.connections.erase(&connection); // destroys the connection
+}
@@ -0,0 +1,93 @@
+#ifndef CHATSERVER_H_
+#define CHATSERVER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "conversationengine.h"
+
+// Event-driven TCP front end for a ConversationEngine (Linux, epoll). Every reactor thread has its own
+// epoll instance and its own listening socket bound with SO_REUSEPORT, so the kernel spreads new
+// connections over the reactors and each connection is handled by one thread for its whole lifetime,
+// without any locking in the server. Every connection is one session of the engine: the greeting is
+// sent on connect and the session ends when the connection is closed. Messages in both directions are
+// frames of a 4-byte big-endian length followed by that many bytes of text.
+class ChatServer
+{
+public:
+    // proprietary type definitions
+    static constexpr uint32_t kMaxFrameLength = 64 * 1024;   // a longer message closes the connection
+    static constexpr size_t kMaxPendingOutput = 1024 * 1024; // reading pauses while more answer bytes are unsent
+
+private:
+    struct Connection
+    {
+        int fd;
+        ConversationEngine::SessionID session;
+        std::string input;   // received bytes, starting with the first unprocessed frame
+        std::string output;  // framed answers, starting at outputOffset
+        size_t outputOffset;
+        uint32_t events;     // epoll events the connection is registered for
+    };
+
+    struct Reactor
+    {
+        int epollFd;
+        int listenFd;
+        int wakeFd; // eventfd, signalled by Stop
+        std::unordered_map<Connection *, std::unique_ptr<Connection>> connections; // reactor thread only
+        std::vector<char> readBuffer; // scratch memory of this reactor
+        std::string answer;
+        std::thread thread;
+    };
+
+    // data handles (not owned)
+    ConversationEngine *_engine;
+
+    // proprietary members
+    std::vector<std::unique_ptr<Reactor>> _reactors;
+    size_t _numReactors;
+    uint16_t _port;
+    std::atomic<size_t> _numConnections;
+
+    // proprietary functions
+    int CreateListenSocket(uint16_t port);
+    void Run(Reactor &reactor);
+    void Accept(Reactor &reactor);
+    void HandleEvents(Reactor &reactor, Connection &connection, uint32_t events);
+    bool Read(Reactor &reactor, Connection &connection);    // returns false if the connection is to be closed
+    bool Process(Reactor &reactor, Connection &connection); // answers complete frames, returns false on a malformed frame
+    bool Flush(Connection &connection);                     // returns false if the connection is to be closed
+    void UpdateEvents(Reactor &reactor, Connection &connection);
+    void Close(Reactor &reactor, Connection &connection);
+
+public:
+    // constructor / destructor
+    explicit ChatServer(ConversationEngine &engine, size_t numReactors = 0); // 0 uses all hardware threads
+    ~ChatServer(); // stops the server
+
+    // the reactor threads refer to this instance
+    ChatServer(const ChatServer &source) = delete;
+    ChatServer &operator=(const ChatServer &source) = delete;
+
+    // getter / setter
+    uint16_t GetPort() const { return _port; }
+    size_t GetNumberOfReactors() const { return _numReactors; }
+    size_t GetNumberOfConnections() const { return _numConnections.load(std::memory_order_relaxed); }
+
+    // listens on all interfaces (port 0 picks a free port, see GetPort), returns false if a socket cannot be set up
+    bool Start(uint16_t port);
+    void Stop(); // closes all connections and ends their sessions
+
+    // framing, e.g. for clients
+    static void AppendFrame(std::string &buffer, std::string_view message);
+};
+
+#endif /* CHATSERVER_H_ */
@@ -0,0 +1,116 @@
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <pthread.h>
+#include <string>
+
+#include "answergraph.h"
+#include "chatserver.h"
+#include "conversationengine.h"
+#include "graphloader.h"
+#include "graphwatcher.h"
+#include "instrumentation.h"
+#ifdef MEMBOT_EMBEDDED_ANSWER_GRAPH
+#include "embeddedgraph.h"
+#endif
+
+// network front end: serves one conversation per TCP connection (length-prefixed frames, see ChatServer)
+// until it receives SIGINT or SIGTERM
+int main(int argc, char *argv[])
+{
+    // the signals are received by sigwait only, so they are blocked before any thread is started
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    // metrics and trace exports are configured through the environment
+    ConfigureInstrumentationFromEnvironment();
+
+    // the options mean the same as for membot_cli, --threads sets the number of reactors (default: all cores)
+    unsigned long port = 7070, numThreads = 0, cacheCapacity = 0;
+    unsigned long long seed = 0;
+    bool hasSeed = false, matchWords = false, watch = false;
+    int arg = 1;
+    for (; arg < argc; ++arg)
+    {
+        std::string option(argv[arg]);
+        if (option == "--port" && arg + 1 < argc)
+            port = std::strtoul(argv[++arg], nullptr, 10);
+        else if (option == "--threads" && arg + 1 < argc)
+            numThreads = std::strtoul(argv[++arg], nullptr, 10);
+        else if (option == "--seed" && arg + 1 < argc)
+        {
+            seed = std::strtoull(argv[++arg], nullptr, 10);
+            hasSeed = true;
+        }
+        else if (option == "--words")
+            matchWords = true;
+        else if (option == "--cache" && arg + 1 < argc)
+            cacheCapacity = std::strtoul(argv[++arg], nullptr, 10);
+        else if (option == "--watch")
+            watch = true;
+        else
+            break;
+    }
+    if (argc > arg + 1 || port > 65535)
+    {
+        std::cout << "Usage: membot_server [--port N] [--threads N] [--seed N] [--words] [--cache N] [--watch] [answergraph.txt | answergraph.bin]"
+                  << std::endl;
+        return 2;
+    }
+
+    std::string filename = arg < argc ? argv[arg] : "../src/answergraph.txt";
+    std::unique_ptr<AnswerGraph> graph;
+#ifdef MEMBOT_EMBEDDED_ANSWER_GRAPH
+    // without a file argument the graph compiled into the executable is used (it cannot be watched)
+    if (arg == argc)
+    {
+        size_t size;
+        const void *image = GetEmbeddedAnswerGraph(size);
+        graph = LoadAnswerGraphImage(image, size);
+        watch = false;
+    }
+    else
+#endif
+        graph = LoadAnswerGraph(filename);
+    if (graph == nullptr || graph->GetRootNode() == nullptr)
+        return 1;
+
+    // same preparation for the loaded and for every reloaded graph
+    auto prepare = [matchWords, cacheCapacity](std::unique_ptr<AnswerGraph> &graph) {
+        if (matchWords)
+            graph->EnableWordMatching();
+        graph->EnableResponseCache(cacheCapacity);
+    };
+    prepare(graph);
+    std::unique_ptr<ConversationEngine> engine;
+    if (hasSeed)
+        engine = std::make_unique<ConversationEngine>(std::move(graph), 0, seed);
+    else
+        engine = std::make_unique<ConversationEngine>(std::move(graph), 0);
+
+    // a changed graph file replaces the graph of all sessions, each continues at the node with the same ID
+    std::unique_ptr<AnswerGraphWatcher> watcher;
+    if (watch)
+    {
+        watcher = std::make_unique<AnswerGraphWatcher>(filename, std::chrono::milliseconds(1000), [&engine, prepare](std::unique_ptr<AnswerGraph> graph) {
+            prepare(graph);
+            engine->ReplaceAnswerGraph(std::move(graph));
+        });
+    }
+
+    ChatServer server(*engine, numThreads);
+    if (!server.Start(uint16_t(port)))
+        return 1;
+    std::cerr << "Listening on port " << server.GetPort() << " with " << server.GetNumberOfReactors() << " reactors" << std::endl;
+
+    int signal;
+    sigwait(&signals, &signal);
+    server.Stop();
+    watcher.reset();
+    return 0;
+}
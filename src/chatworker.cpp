@@ -0,0 +1,102 @@
+
+#include "log.h"
+#include "chatlogic.h"
+#include "chatworker.h"
+
+ChatWorker::ChatWorker(ChatLogic *chatLogic, std::function<void()> notify, size_t capacity)
+    : _chatLogic(chatLogic), _notify(std::move(notify)), _requests(capacity), _responses(capacity),
+      _lastPosted(0), _currentRequest(0), _cancelledUpTo(0), _lastFinished(0), _isStopping(false)
+{
+    // answers are queued instead of being passed on directly; the greeting sent while loading
+    // the graph (before any request is posted) is queued as well
+    _chatLogic->SetResponseHandler([this](std::string_view text) { PushResponse(text); });
+
+    _thread = std::thread(&ChatWorker::Run, this);
+}
+
+ChatWorker::~ChatWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(_wakeMutex);
+        _isStopping = true;
+    }
+    _wakeCondition.notify_one();
+    _thread.join();
+
+    _chatLogic->SetResponseHandler(nullptr);
+}
+
+ChatWorker::RequestID ChatWorker::Submit(std::string message, bool supersede)
+{
+    RequestID id = _lastPosted + 1;
+    if (!_requests.TryPush(Request{id, std::move(message)}))
+    {
+        MEMBOT_LOG_ERROR("Error: too many pending messages, message is ignored!");
+        return 0;
+    }
+    _lastPosted = id;
+
+    if (supersede)
+        CancelUpTo(id - 1);
+
+    // the lock only orders the wake-up with the worker going to sleep, the queue itself is lock-free
+    {
+        std::lock_guard<std::mutex> lock(_wakeMutex);
+    }
+    _wakeCondition.notify_one();
+    return id;
+}
+
+void ChatWorker::CancelUpTo(RequestID request)
+{
+    RequestID cancelled = _cancelledUpTo.load(std::memory_order_relaxed);
+    while (cancelled < request && !_cancelledUpTo.compare_exchange_weak(cancelled, request, std::memory_order_release))
+        ;
+}
+
+bool ChatWorker::PopResponse(Response &response)
+{
+    return _responses.TryPop(response);
+}
+
+void ChatWorker::Run()
+{
+    Request request;
+    while (true)
+    {
+        while (_requests.TryPop(request))
+        {
+            // superseded requests are skipped without touching the conversation state
+            if (request.id > _cancelledUpTo.load(std::memory_order_acquire))
+            {
+                _currentRequest = request.id;
+                _chatLogic->SendMessageToChatbot(request.message);
+            }
+
+            _lastFinished.store(request.id, std::memory_order_release);
+            if (_notify)
+                _notify();
+
+            if (_isStopping)
+                return;
+        }
+
+        std::unique_lock<std::mutex> lock(_wakeMutex);
+        _wakeCondition.wait(lock, [this] { return _isStopping || !_requests.IsEmpty(); });
+        if (_isStopping)
+            return;
+    }
+}
+
+void ChatWorker::PushResponse(std::string_view text)
+{
+    // a request cancelled while it was processed keeps its answer, because the chatbot has already moved on;
+    // wait for the posting thread to catch up if it lags behind by a full queue
+    Response response{_currentRequest, std::string(text)};
+    while (!_responses.TryPush(std::move(response)))
+    {
+        if (_isStopping)
+            return;
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef CHATWORKER_H_
+#define CHATWORKER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "spscqueue.h"
+
+class ChatLogic; // forward declaration
+
+// runs ChatLogic on a worker thread, so that matching never blocks the thread posting messages.
+// Requests and responses are passed through lock-free single-producer / single-consumer queues;
+// the notify callback is invoked on the worker thread whenever a request has been finished and
+// should only schedule a call of PopResponse on the posting thread (e.g. with wxQueueEvent).
+// Cancellation (Submit with supersede, CancelUpTo) is offered to callers that drop stale messages;
+// the GUI does not use it and answers every message.
+class ChatWorker
+{
+public:
+    // proprietary type definitions
+    typedef uint64_t RequestID; // 0 is used for answers which are not triggered by a request (greeting)
+
+    struct Response
+    {
+        RequestID request;
+        std::string text;
+    };
+
+private:
+    struct Request
+    {
+        RequestID id;
+        std::string message;
+    };
+
+    // data handles (not owned)
+    ChatLogic *_chatLogic;
+    std::function<void()> _notify;
+
+    // proprietary members
+    SpscQueue<Request> _requests;   // posting thread -> worker thread
+    SpscQueue<Response> _responses; // worker thread -> posting thread
+    RequestID _lastPosted;          // posting thread only
+    RequestID _currentRequest;      // worker thread only
+    std::atomic<RequestID> _cancelledUpTo;
+    std::atomic<RequestID> _lastFinished;
+    std::atomic<bool> _isStopping;
+
+    // the worker sleeps while there are no requests
+    std::mutex _wakeMutex;
+    std::condition_variable _wakeCondition;
+    std::thread _thread;
+
+    // proprietary functions
+    void Run();
+    void PushResponse(std::string_view text);
+
+public:
+    // constructor / destructor
+    ChatWorker(ChatLogic *chatLogic, std::function<void()> notify, size_t capacity = 256);
+    ~ChatWorker(); // finishes the current request and joins the worker thread
+
+    // the worker thread refers to this instance
+    ChatWorker(const ChatWorker &source) = delete;
+    ChatWorker &operator=(const ChatWorker &source) = delete;
+
+    // getter / setter
+    bool IsBusy() const { return _lastFinished.load(std::memory_order_acquire) < _lastPosted; }
+
+    // proprietary functions (posting thread)
+    RequestID Submit(std::string message, bool supersede = false); // supersede cancels all earlier requests, returns 0 if the queue is full
+    void CancelUpTo(RequestID request);                                 // requests not started yet are skipped, running ones are still answered
+    bool PopResponse(Response &response);
+};
+
+#endif /* CHATWORKER_H_ */
@@ -0,0 +1,297 @@
+#include <cstdint>
+
+#include "log.h"
+#include "answergraph.h"
+#include "graphnode.h"
+#include "levenshtein.h"
+#include "textnormalizer.h"
+#include "conversationengine.h"
+
+namespace
+{
+// scratch memory for string matching, one per thread so that sessions never share it
+thread_local LevenshteinEngine levenshtein;
+thread_local std::string normalizedMessage;
+
+// snapshot encoding: format byte, graph fingerprint (fixed 8 bytes), zigzag varint node ID, generator state
+// (fixed 8 bytes), varint generator stream, varint number of history entries, then message and answer of
+// each entry as varint length and bytes; all fixed-size values are little-endian
+const uint8_t kSnapshotFormat = 1;
+
+// node IDs are signed, zigzag encoding keeps small negative IDs short as well
+uint32_t EncodeZigZag(int value) { return (uint32_t(value) << 1) ^ uint32_t(value >> 31); }
+int DecodeZigZag(uint32_t value) { return int((value >> 1) ^ (0u - (value & 1u))); }
+
+void AppendFixed64(std::string &out, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i)
+        out.push_back(char(value >> (8 * i)));
+}
+
+void AppendVarint(std::string &out, uint64_t value)
+{
+    for (; value >= 0x80; value >>= 7)
+        out.push_back(char(value | 0x80));
+    out.push_back(char(value));
+}
+
+void AppendString(std::string &out, std::string_view str)
+{
+    AppendVarint(out, str.size());
+    out.append(str.data(), str.size());
+}
+
+// the readers consume the value from the front of the input, they return false if it is truncated
+bool ReadFixed64(std::string_view &in, uint64_t &value)
+{
+    if (in.size() < 8)
+        return false;
+    value = 0;
+    for (int i = 0; i < 8; ++i)
+        value |= uint64_t(uint8_t(in[i])) << (8 * i);
+    in.remove_prefix(8);
+    return true;
+}
+
+bool ReadVarint(std::string_view &in, uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && !in.empty(); shift += 7)
+    {
+        uint8_t byte = uint8_t(in.front());
+        in.remove_prefix(1);
+        value |= uint64_t(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+bool ReadString(std::string_view &in, std::string &str)
+{
+    uint64_t length;
+    if (!ReadVarint(in, length) || length > in.size())
+        return false;
+    str.assign(in.data(), length);
+    in.remove_prefix(length);
+    return true;
+}
+} // namespace
+
+ConversationEngine::ConversationEngine(std::shared_ptr<const AnswerGraph> graph, size_t maxHistory)
+    : ConversationEngine(std::move(graph), maxHistory, Pcg32::RandomSeed())
+{
+}
+
+ConversationEngine::ConversationEngine(std::shared_ptr<const AnswerGraph> graph, size_t maxHistory, uint64_t seed)
+    : _published(std::make_shared<const PublishedGraph>(PublishedGraph{std::move(graph), 0})), _maxHistory(maxHistory), _seed(seed),
+      _nextSession(kInvalidSession + 1)
+{
+}
+
+bool ConversationEngine::ReplaceAnswerGraph(std::shared_ptr<const AnswerGraph> graph)
+{
+    if (graph == nullptr || graph->GetRootNode() == nullptr)
+    {
+        MEMBOT_LOG_ERROR("Error: answer graph has no root node, it does not replace the current one!");
+        return false;
+    }
+
+    // readers holding the previous graph keep it alive until they are done, nobody waits for anybody
+    // (concurrent replacements are serialized by the compare-exchange, so versions are unique)
+    std::shared_ptr<const PublishedGraph> current = GetPublishedGraph();
+    std::shared_ptr<const PublishedGraph> next;
+    do
+    {
+        next = std::make_shared<const PublishedGraph>(PublishedGraph{graph, current->version + 1});
+    } while (!std::atomic_compare_exchange_weak(&_published, &current, next));
+    return true;
+}
+
+size_t ConversationEngine::GetNumberOfSessions() const
+{
+    size_t count = 0;
+    for (const Shard &shard : _shards)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        count += shard.sessions.size();
+    }
+    return count;
+}
+
+ConversationEngine::SessionID ConversationEngine::CreateSession(std::string *greeting)
+{
+    std::shared_ptr<const PublishedGraph> published = GetPublishedGraph();
+    const GraphNode *root = published->graph ? published->graph->GetRootNode() : nullptr;
+    if (root == nullptr)
+    {
+        MEMBOT_LOG_ERROR("Error: answer graph has no root node, session is not created!");
+        return kInvalidSession;
+    }
+
+    SessionID id = _nextSession.fetch_add(1, std::memory_order_relaxed);
+    auto session = std::make_shared<Session>();
+    MoveToNode(*session, *published, root);
+    session->generator.Seed(_seed, id);
+
+    // the greeting is the answer of the root node
+    std::string_view answer = SelectAnswer(*session, *published->graph);
+    AddToHistory(*session, std::string_view(), answer);
+    if (greeting)
+        greeting->assign(answer);
+
+    Shard &shard = GetShard(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.sessions.emplace(id, std::move(session));
+    return id;
+}
+
+bool ConversationEngine::EndSession(SessionID id)
+{
+    // a reply still in progress keeps its session alive until it is done
+    Shard &shard = GetShard(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.sessions.erase(id) > 0;
+}
+
+bool ConversationEngine::GetHistory(SessionID id, std::vector<HistoryEntry> &history) const
+{
+    std::shared_ptr<Session> session = FindSession(id);
+    if (!session)
+        return false;
+
+    std::lock_guard<std::mutex> lock(session->mutex);
+    history.assign(session->history.begin(), session->history.end());
+    return true;
+}
+
+bool ConversationEngine::Respond(SessionID id, std::string_view message, std::string &answer)
+{
+    std::shared_ptr<Session> session = FindSession(id);
+    if (!session)
+        return false;
+
+    // only the session is locked, the graph is immutable and stays alive while it is used here
+    std::shared_ptr<const PublishedGraph> published = GetPublishedGraph();
+    const AnswerGraph &graph = *published->graph;
+    std::lock_guard<std::mutex> lock(session->mutex);
+
+    // after the graph has been replaced, the conversation continues at the node with the same ID
+    const GraphNode *current = nullptr;
+    if (session->graphVersion == published->version)
+        current = graph.GetNodeAtIndex(session->currentNode);
+    else if ((current = graph.FindNode(session->currentNodeID)) == nullptr)
+        current = graph.GetRootNode();
+
+    NormalizeText(message, normalizedMessage);
+    MoveToNode(*session, *published, graph.SelectNextNode(current, normalizedMessage, levenshtein));
+
+    std::string_view selected = SelectAnswer(*session, graph);
+    AddToHistory(*session, message, selected);
+    answer.assign(selected);
+    return true;
+}
+
+bool ConversationEngine::SaveSession(SessionID id, std::string &snapshot, bool withHistory) const
+{
+    std::shared_ptr<Session> session = FindSession(id);
+    if (!session)
+        return false;
+
+    // the fingerprint of the graph the current node belongs to, which may be older than the published one
+    // until the session receives its next message (then only the node ID is saved, as for a reload)
+    std::shared_ptr<const PublishedGraph> published = GetPublishedGraph();
+    std::lock_guard<std::mutex> lock(session->mutex);
+    uint64_t fingerprint = session->graphVersion == published->version ? published->graph->GetFingerprint() : 0;
+
+    snapshot.clear();
+    snapshot.push_back(char(kSnapshotFormat));
+    AppendFixed64(snapshot, fingerprint);
+    AppendVarint(snapshot, EncodeZigZag(session->currentNodeID));
+    AppendFixed64(snapshot, session->generator.GetState());
+    AppendVarint(snapshot, session->generator.GetIncrement() >> 1);
+    AppendVarint(snapshot, withHistory ? session->history.size() : 0);
+    if (withHistory)
+    {
+        for (const HistoryEntry &entry : session->history)
+        {
+            AppendString(snapshot, entry.message);
+            AppendString(snapshot, entry.answer);
+        }
+    }
+    return true;
+}
+
+ConversationEngine::SessionID ConversationEngine::RestoreSession(std::string_view snapshot, bool requireSameGraph)
+{
+    uint64_t fingerprint, encodedNodeID, state, stream, numEntries;
+    if (snapshot.empty() || uint8_t(snapshot.front()) != kSnapshotFormat)
+        return kInvalidSession;
+    snapshot.remove_prefix(1);
+    if (!ReadFixed64(snapshot, fingerprint) || !ReadVarint(snapshot, encodedNodeID) || !ReadFixed64(snapshot, state) ||
+        !ReadVarint(snapshot, stream) || !ReadVarint(snapshot, numEntries))
+        return kInvalidSession;
+
+    auto session = std::make_shared<Session>();
+    for (uint64_t i = 0; i < numEntries; ++i)
+    {
+        HistoryEntry entry;
+        if (!ReadString(snapshot, entry.message) || !ReadString(snapshot, entry.answer))
+            return kInvalidSession;
+        if (_maxHistory == 0)
+            continue;
+        if (session->history.size() == _maxHistory)
+            session->history.pop_front();
+        session->history.push_back(std::move(entry));
+    }
+    if (!snapshot.empty())
+        return kInvalidSession;
+
+    std::shared_ptr<const PublishedGraph> published = GetPublishedGraph();
+    const AnswerGraph &graph = *published->graph;
+    if (requireSameGraph && fingerprint != graph.GetFingerprint())
+        return kInvalidSession;
+
+    // as after a reload, the conversation continues at the node with the same ID
+    const GraphNode *current = encodedNodeID <= UINT32_MAX ? graph.FindNode(DecodeZigZag(uint32_t(encodedNodeID))) : nullptr;
+    if (current == nullptr)
+        current = graph.GetRootNode();
+    MoveToNode(*session, *published, current);
+    session->generator.SetState(state, stream << 1);
+
+    SessionID id = _nextSession.fetch_add(1, std::memory_order_relaxed);
+    Shard &shard = GetShard(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.sessions.emplace(id, std::move(session));
+    return id;
+}
+
+std::shared_ptr<ConversationEngine::Session> ConversationEngine::FindSession(SessionID id) const
+{
+    const Shard &shard = GetShard(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.sessions.find(id);
+    return it == shard.sessions.end() ? nullptr : it->second;
+}
+
+void ConversationEngine::MoveToNode(Session &session, const PublishedGraph &published, const GraphNode *node) const
+{
+    session.graphVersion = published.version;
+    session.currentNode = published.graph->GetNodeIndex(node);
+    session.currentNodeID = node->GetID();
+}
+
+std::string_view ConversationEngine::SelectAnswer(Session &session, const AnswerGraph &graph) const
+{
+    return graph.GetNodeAtIndex(session.currentNode)->SelectAnswer(session.generator);
+}
+
+void ConversationEngine::AddToHistory(Session &session, std::string_view message, std::string_view answer) const
+{
+    if (_maxHistory == 0)
+        return;
+
+    if (session.history.size() == _maxHistory)
+        session.history.pop_front();
+    session.history.push_back(HistoryEntry{std::string(message), std::string(answer)});
+}
@@ -0,0 +1,116 @@
+#ifndef CONVERSATIONENGINE_H_
+#define CONVERSATIONENGINE_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "rng.h"
+
+class AnswerGraph; // forward declaration
+class GraphNode;   // forward declaration
+
+// Headless chatbot for many concurrent conversations. The answer graph is immutable, so it is
+// shared by all sessions without any locking. Each session holds nothing but its current node,
+// its random number generator and a short history. The graph can be replaced at any time (e.g. by
+// an AnswerGraphWatcher): the new graph is published with an atomic pointer swap, every session
+// moves to the node with the same ID when it receives its next message, and the previous graph is
+// freed once the last reply using it has finished.
+// All public functions may be called from several threads at once.
+class ConversationEngine
+{
+public:
+    // proprietary type definitions
+    typedef uint64_t SessionID;
+    static constexpr SessionID kInvalidSession = 0;
+
+    struct HistoryEntry
+    {
+        std::string message; // message of the user (empty for the greeting)
+        std::string answer;  // answer of the chatbot
+    };
+
+private:
+    struct Session
+    {
+        std::mutex mutex;              // serializes messages within one conversation
+        uint64_t graphVersion;         // version of the published graph currentNode refers to
+        uint32_t currentNode;          // index of the current node in that graph
+        int currentNodeID;             // ID of the current node, which is kept when the graph is replaced
+        Pcg32 generator;               // selects one of several node answers
+        std::deque<HistoryEntry> history;
+    };
+
+    // sessions are spread over several maps so that creating and ending sessions scales as well
+    struct Shard
+    {
+        mutable std::mutex mutex;
+        std::unordered_map<SessionID, std::shared_ptr<Session>> sessions;
+    };
+    static constexpr size_t kNumShards = 64;
+
+    // an answer graph together with the number of graphs published before it
+    struct PublishedGraph
+    {
+        std::shared_ptr<const AnswerGraph> graph;
+        uint64_t version;
+    };
+
+    // data handles (shared, only accessed with std::atomic_load / std::atomic_store)
+    std::shared_ptr<const PublishedGraph> _published;
+
+    // proprietary members
+    size_t _maxHistory;                  // history entries kept per session
+    uint64_t _seed;                      // base seed for the session generators, each session uses its own stream
+    std::atomic<SessionID> _nextSession; // IDs are never reused
+    std::array<Shard, kNumShards> _shards;
+
+    // proprietary functions
+    Shard &GetShard(SessionID id) { return _shards[id % kNumShards]; }
+    const Shard &GetShard(SessionID id) const { return _shards[id % kNumShards]; }
+    std::shared_ptr<Session> FindSession(SessionID id) const;
+    std::shared_ptr<const PublishedGraph> GetPublishedGraph() const { return std::atomic_load(&_published); }
+    void MoveToNode(Session &session, const PublishedGraph &published, const GraphNode *node) const;
+    std::string_view SelectAnswer(Session &session, const AnswerGraph &graph) const;
+    void AddToHistory(Session &session, std::string_view message, std::string_view answer) const;
+
+public:
+    // constructor / destructor
+    ConversationEngine(std::shared_ptr<const AnswerGraph> graph, size_t maxHistory = 16);
+    ConversationEngine(std::shared_ptr<const AnswerGraph> graph, size_t maxHistory, uint64_t seed); // reproducible answers per session ID
+
+    // sessions refer to the engine's graph, so the engine can neither be copied nor moved
+    ConversationEngine(const ConversationEngine &source) = delete;
+    ConversationEngine &operator=(const ConversationEngine &source) = delete;
+
+    // getter / setter
+    std::shared_ptr<const AnswerGraph> GetAnswerGraph() const { return GetPublishedGraph()->graph; }
+    size_t GetNumberOfSessions() const;
+
+    // session handling
+    SessionID CreateSession(std::string *greeting = nullptr); // starts at the root node, returns kInvalidSession if the graph has none
+    bool EndSession(SessionID id);                            // returns false if the session does not exist
+    bool GetHistory(SessionID id, std::vector<HistoryEntry> &history) const;
+
+    // snapshots hold the whole state of a session in a few bytes (fingerprint of the graph, ID of the current node,
+    // state of the generator and optionally the history), e.g. to move a conversation to another host or to keep it
+    // in a key-value store; a restored session gets a new ID and continues at the node with the same ID (or at the
+    // root node if the graph has no such node), with the same sequence of answers
+    bool SaveSession(SessionID id, std::string &snapshot, bool withHistory = false) const; // returns false if the session does not exist
+    SessionID RestoreSession(std::string_view snapshot, bool requireSameGraph = false);    // returns kInvalidSession if malformed or from another graph (if required)
+
+    // returns false (and keeps the current graph) if the new graph has no root node
+    bool ReplaceAnswerGraph(std::shared_ptr<const AnswerGraph> graph);
+
+    // communication
+    bool Respond(SessionID id, std::string_view message, std::string &answer); // returns false if the session does not exist
+};
+
+#endif /* CONVERSATIONENGINE_H_ */
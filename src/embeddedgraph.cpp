@@ -0,0 +1,8 @@
+#include "embeddedanswergraphdata.h" // generated by answergraphc --header at build time
+#include "embeddedgraph.h"
+
+const void *GetEmbeddedAnswerGraph(size_t &size)
+{
+    size = kEmbeddedAnswerGraphSize;
+    return kEmbeddedAnswerGraph;
+}
@@ -0,0 +1,10 @@
+#ifndef EMBEDDEDGRAPH_H_
+#define EMBEDDEDGRAPH_H_
+
+#include <cstddef>
+
+// binary image of the answer graph compiled into the executable (see MEMBOT_EMBED_ANSWER_GRAPH),
+// aligned for use in place and valid for the whole lifetime of the program
+const void *GetEmbeddedAnswerGraph(size_t &size);
+
+#endif /* EMBEDDEDGRAPH_H_ */
@@ -0,0 +1,122 @@
+#include <algorithm>
+
+#include "stringpool.h"
+#include "exactmatchindex.h"
+
+ExactMatchIndex::ExactMatchIndex()
+{
+    _buffer = nullptr;
+    _entries = nullptr;
+}
+
+void ExactMatchIndex::Build(const char *buffer, const KeywordMatcher::Entry *entries, const std::vector<uint32_t> &nodeOffsets, const std::vector<uint64_t> &hashes)
+{
+    _buffer = buffer;
+    _entries = entries;
+    _tables.assign(nodeOffsets.empty() ? 0 : nodeOffsets.size() - 1, Table{0, 0, 0, 0, 0});
+    _slots.clear();
+    _seeds.clear();
+
+    std::vector<uint32_t> bucketStarts, positions, order, buckets;
+    for (size_t node = 0; node < _tables.size(); ++node)
+    {
+        uint32_t first = nodeOffsets[node];
+        uint32_t count = nodeOffsets[node + 1] - first;
+        if (count == 0 || count >= UINT16_MAX)
+            continue;
+
+        uint8_t numBits = 1;
+        while ((size_t(1) << numBits) * 4 < size_t(count) * 5)
+            ++numBits;
+        uint8_t numBucketBits = 0;
+        while ((size_t(1) << numBucketBits) * 4 < size_t(count))
+            ++numBucketBits;
+        size_t numBuckets = size_t(1) << numBucketBits;
+
+        // the entries grouped by bucket, and the buckets from the largest to the smallest
+        bucketStarts.assign(numBuckets + 1, 0);
+        for (uint32_t i = 0; i < count; ++i)
+            ++bucketStarts[GetBucket(hashes[first + i], numBucketBits) + 1];
+        for (size_t b = 0; b < numBuckets; ++b)
+            bucketStarts[b + 1] += bucketStarts[b];
+        order.resize(count);
+        positions.assign(bucketStarts.begin(), bucketStarts.end() - 1);
+        for (uint32_t i = 0; i < count; ++i)
+            order[positions[GetBucket(hashes[first + i], numBucketBits)]++] = i;
+        buckets.resize(numBuckets);
+        for (uint32_t b = 0; b < numBuckets; ++b)
+            buckets[b] = b;
+        std::stable_sort(buckets.begin(), buckets.end(), [&bucketStarts](uint32_t a, uint32_t b) {
+            return bucketStarts[a + 1] - bucketStarts[a] > bucketStarts[b + 1] - bucketStarts[b];
+        });
+
+        Table table{uint32_t(_slots.size()), uint32_t(_seeds.size()), numBits, numBucketBits, 0};
+        _slots.resize(_slots.size() + (size_t(1) << numBits), 0);
+        _seeds.resize(_seeds.size() + numBuckets, 0);
+        uint16_t *slots = _slots.data() + table.firstSlot;
+
+        // a failed seed only resets the slots it has taken; a bucket that cannot be placed under any seed
+        // (keywords with equal 64-bit hashes) leaves the node without a table, so it is matched as before
+        bool isPlaced = true;
+        for (size_t b = 0; b < numBuckets && isPlaced; ++b)
+        {
+            const uint32_t *bucket = order.data() + bucketStarts[buckets[b]];
+            uint32_t size = bucketStarts[buckets[b] + 1] - bucketStarts[buckets[b]];
+            if (size == 0)
+                break;
+
+            isPlaced = false;
+            for (uint32_t seed = 0; !isPlaced && seed <= UINT16_MAX; ++seed)
+            {
+                uint32_t numTaken = 0;
+                for (; numTaken < size; ++numTaken)
+                {
+                    uint16_t &slot = slots[GetSlot(hashes[first + bucket[numTaken]], uint16_t(seed), numBits)];
+                    if (slot != 0)
+                        break;
+                    slot = uint16_t(bucket[numTaken] + 1);
+                }
+
+                isPlaced = numTaken == size;
+                if (isPlaced)
+                    _seeds[table.firstBucket + buckets[b]] = uint16_t(seed);
+                for (uint32_t i = 0; !isPlaced && i < numTaken; ++i)
+                    slots[GetSlot(hashes[first + bucket[i]], uint16_t(seed), numBits)] = 0;
+            }
+        }
+
+        if (isPlaced)
+            _tables[node] = table;
+        else
+        {
+            _slots.resize(table.firstSlot);
+            _seeds.resize(table.firstBucket);
+        }
+    }
+}
+
+void ExactMatchIndex::Clear()
+{
+    _tables.clear();
+    _slots.clear();
+    _seeds.clear();
+}
+
+int ExactMatchIndex::FindEntry(uint32_t node, std::string_view message, uint32_t firstEntry) const
+{
+    if (node >= _tables.size() || _tables[node].numBits == 0)
+        return -1;
+
+    // the only keyword the message can be equal to
+    const Table &table = _tables[node];
+    uint64_t hash = StringPool::Hash(message);
+    uint16_t seed = _seeds[table.firstBucket + GetBucket(hash, table.numBucketBits)];
+    uint16_t slot = _slots[table.firstSlot + GetSlot(hash, seed, table.numBits)];
+    if (slot == 0)
+        return -1;
+
+    const KeywordMatcher::Entry &entry = _entries[firstEntry + slot - 1];
+    if (std::string_view(_buffer + entry.offset, entry.length) != message)
+        return -1;
+    return int(firstEntry + slot - 1);
+}
@@ -0,0 +1,64 @@
+#ifndef EXACTMATCHINDEX_H_
+#define EXACTMATCHINDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "keywordmatcher.h"
+
+// Perfect hash table per node from the normalized keywords of its child edges to their keyword matching
+// entries, so that a message equal to a keyword is routed with one hash lookup instead of a Levenshtein
+// scan. The tables are built by hash and displace: the keywords of a node are split into buckets of about
+// four, and the buckets are placed from the largest to the smallest, each with the first seed under which
+// its keywords land in free slots of a power of two number of slots (at most 0.8 occupied). A lookup reads
+// the seed of its bucket and probes exactly one slot, and building a node is linear in its keywords.
+// Keywords are hashed with StringPool::Hash, so the hashes computed while interning them can be reused.
+class ExactMatchIndex
+{
+private:
+    struct Table
+    {
+        uint32_t firstSlot;
+        uint32_t firstBucket;
+        uint8_t numBits;       // log2 of the number of slots, zero if the node has no table
+        uint8_t numBucketBits; // log2 of the number of buckets
+        uint16_t reserved;
+    };
+
+    // proprietary members
+    const char *_buffer;                   // normalized keywords of the graph (not owned)
+    const KeywordMatcher::Entry *_entries; // keyword matching entries of the graph (not owned)
+    std::vector<Table> _tables;            // one per node
+    std::vector<uint16_t> _slots;          // position of the entry among the entries of its node plus one, zero if empty
+    std::vector<uint16_t> _seeds;          // one per bucket
+
+    // proprietary functions
+    static size_t GetBucket(uint64_t hash, uint8_t numBucketBits)
+    {
+        return numBucketBits == 0 ? 0 : size_t((hash * 0xC2B2AE3D27D4EB4Full) >> (64 - numBucketBits));
+    }
+    static size_t GetSlot(uint64_t hash, uint16_t seed, uint8_t numBits)
+    {
+        return size_t(((hash ^ (uint64_t(seed) * 0xD6E8FEB86659FD93ull)) * 0x9E3779B97F4A7C15ull) >> (64 - numBits));
+    }
+
+public:
+    // constructor
+    ExactMatchIndex();
+
+    // getter / setter
+    size_t GetNumberOfSlots() const { return _slots.size(); }
+
+    // proprietary functions
+    // builds the tables over all keyword matching entries (buffer and entries must outlive the index); the entries of
+    // node i are [nodeOffsets[i], nodeOffsets[i + 1]) and hashes holds StringPool::Hash of the keyword of each entry
+    void Build(const char *buffer, const KeywordMatcher::Entry *entries, const std::vector<uint32_t> &nodeOffsets, const std::vector<uint64_t> &hashes);
+    void Clear();
+
+    // returns the matching entry of the node whose keyword equals the normalized message, or -1
+    int FindEntry(uint32_t node, std::string_view message, uint32_t firstEntry) const;
+};
+
+#endif /* EXACTMATCHINDEX_H_ */
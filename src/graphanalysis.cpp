@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <string_view>
+
+#include "answergraph.h"
+#include "graphedge.h"
+#include "graphnode.h"
+#include "textnormalizer.h"
+#include "graphanalysis.h"
+
+AnswerGraphReport AnalyzeAnswerGraph(const AnswerGraph &graph)
+{
+    AnswerGraphReport report;
+    if (graph.GetRootNode() == nullptr)
+        return report;
+
+    // breadth-first search over the child edges, the fallback to the root node adds no further nodes
+    std::vector<bool> isReached(graph.GetNumberOfNodes(), false);
+    std::vector<uint32_t> queue(1, graph.GetNodeIndex(graph.GetRootNode()));
+    isReached[queue.front()] = true;
+    for (size_t next = 0; next < queue.size(); ++next)
+    {
+        const GraphNode *node = graph.GetNodeAtIndex(queue[next]);
+        for (int i = 0; i < node->GetNumberOfChildEdges(); ++i)
+        {
+            uint32_t child = graph.GetNodeIndex(node->GetChildEdgeAtIndex(i)->GetChildNode());
+            if (!isReached[child])
+            {
+                isReached[child] = true;
+                queue.push_back(child);
+            }
+        }
+    }
+
+    std::vector<std::string> seen; // normalized keywords of the current node
+    std::string normalized;
+    for (uint32_t index = 0; index < graph.GetNumberOfNodes(); ++index)
+    {
+        const GraphNode *node = graph.GetNodeAtIndex(index);
+        if (!isReached[index])
+            report.unreachableNodes.push_back(node->GetID());
+        if (node->GetNumberOfChildEdges() == 0)
+            report.deadEndNodes.push_back(node->GetID());
+
+        // the first edge wins on equal distance, so a repeated keyword of a later sibling never selects it
+        seen.clear();
+        for (int i = 0; i < node->GetNumberOfChildEdges(); ++i)
+        {
+            const GraphEdge *edge = node->GetChildEdgeAtIndex(i);
+            bool isMatchable = false;
+            for (std::string_view keyword : edge->GetKeywords())
+            {
+                NormalizeText(keyword, normalized);
+                if (std::find(seen.begin(), seen.end(), normalized) != seen.end())
+                {
+                    report.shadowedKeywords.emplace_back(edge->GetID(), std::string(keyword));
+                    continue;
+                }
+                seen.push_back(normalized);
+                isMatchable = true;
+            }
+            if (!isMatchable)
+                report.unmatchableEdges.push_back(edge->GetID());
+        }
+        report.numKeywords += seen.size();
+    }
+    return report;
+}
@@ -0,0 +1,24 @@
+#ifndef GRAPHANALYSIS_H_
+#define GRAPHANALYSIS_H_
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+class AnswerGraph; // forward declaration
+
+// structural problems of an answer graph, e.g. to review a graph before it is deployed
+struct AnswerGraphReport
+{
+    std::vector<int> unreachableNodes;                         // IDs of nodes no conversation can reach from the root node
+    std::vector<int> deadEndNodes;                             // IDs of nodes without child edges, the next message always returns to the root node
+    std::vector<int> unmatchableEdges;                         // IDs of edges no message can select
+    std::vector<std::pair<int, std::string>> shadowedKeywords; // <edge ID, keyword> equal (once normalized) to an earlier keyword of the node
+    size_t numKeywords = 0;                                   // distinct normalized keywords per node, summed over all nodes
+};
+
+// walks the graph from its root node and compares the keywords of sibling edges
+AnswerGraphReport AnalyzeAnswerGraph(const AnswerGraph &graph);
+
+#endif /* GRAPHANALYSIS_H_ */
@@ -1,22 +1,33 @@
+#include "answergraph.h"
 #include "graphnode.h"
 #include "graphedge.h"
 
-GraphEdge::GraphEdge(int id)
+GraphEdge::GraphEdge(AnswerGraph *graph, int id, uint32_t parentNode, uint32_t childNode)
 {
+    _graph = graph;
     _id = id;
+    _parentNode = parentNode;
+    _childNode = childNode;
+    _firstKeyword = 0;
+    _numKeywords = 0;
 }
 
-void GraphEdge::SetChildNode(GraphNode *childNode)
+const GraphNode *GraphEdge::GetChildNode() const
 {
-    _childNode = childNode;
+    return _graph->GetNodeAtIndex(_childNode);
 }
 
-void GraphEdge::SetParentNode(GraphNode *parentNode)
+const GraphNode *GraphEdge::GetParentNode() const
 {
-    _parentNode = parentNode;
+    return _graph->GetNodeAtIndex(_parentNode);
 }
 
-void GraphEdge::AddToken(std::string token)
+StringList GraphEdge::GetKeywords() const
 {
-    _keywords.push_back(token);
-}
\ No newline at end of file
+    return _graph->GetStrings(_firstKeyword, _numKeywords);
+}
+
+void GraphEdge::AddToken(std::string_view token)
+{
+    _graph->AddKeyword(this, token);
+}
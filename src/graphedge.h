@@ -1,36 +1,43 @@
 #ifndef GRAPHEDGE_H_
 #define GRAPHEDGE_H_
 
-#include <vector>
-#include <string>
+#include <cstdint>
+#include <string_view>
 
-class GraphNode; // forward declaration
+#include "stringpool.h"
 
+// forward declarations
+class AnswerGraph;
+class GraphNode;
+
+// handle to an edge stored in the flat edge array of an AnswerGraph
 class GraphEdge
 {
 private:
+    friend class AnswerGraph;
+
     // data handles (not owned)
-    GraphNode *_childNode;
-    GraphNode *_parentNode;
+    AnswerGraph *_graph; // graph that stores nodes and keywords
 
     // proprietary members
     int _id;
-    std::vector<std::string> _keywords; // list of topics associated with this edge
-    
+    uint32_t _childNode;    // index of the child node in the graph
+    uint32_t _parentNode;   // index of the parent node in the graph
+    uint32_t _firstKeyword; // keywords are a range of strings in the graph
+    uint32_t _numKeywords;  // list of topics associated with this edge
 
 public:
-    // constructor / desctructor
-    GraphEdge(int id);
+    // constructor
+    GraphEdge(AnswerGraph *graph, int id, uint32_t parentNode, uint32_t childNode);
 
     // getter / setter
-    int GetID() { return _id; }
-    void SetChildNode(GraphNode *childNode);
-    void SetParentNode(GraphNode *parentNode);
-    GraphNode *GetChildNode() { return _childNode; }
-    std::vector<std::string> GetKeywords() { return _keywords; }
+    int GetID() const { return _id; }
+    const GraphNode *GetChildNode() const;
+    const GraphNode *GetParentNode() const;
+    StringList GetKeywords() const;
 
     // proprietary functions
-    void AddToken(std::string token);
+    void AddToken(std::string_view token); // add keywords to list (while the graph is being built)
 };
 
-#endif /* GRAPHEDGE_H_ */
\ No newline at end of file
+#endif /* GRAPHEDGE_H_ */
@@ -0,0 +1,371 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MEMBOT_HAVE_MMAP 1
+#endif
+
+#include "log.h"
+#include "graphparser.h"
+#include "nodeindex.h"
+#include "graphfile.h"
+
+namespace
+{
+    const char kMagic[8] = {'M', 'E', 'M', 'B', 'O', 'T', 'G', '\0'};
+
+    // total file size for the given table sizes
+    size_t ComputeFileSize(const AnswerGraphFileHeader &header)
+    {
+        return sizeof(AnswerGraphFileHeader) +
+               size_t(header.numNodes) * sizeof(AnswerGraphFileNode) +
+               size_t(header.numEdges) * sizeof(AnswerGraphFileEdge) +
+               (size_t(header.numNodes) + 1) * sizeof(uint32_t) +
+               size_t(header.numStrings) * sizeof(StringRef) +
+               ((size_t(header.stringDataSize) + 3) & ~size_t(3));
+    }
+
+    template <typename T>
+    void AppendTable(std::string &image, const std::vector<T> &table)
+    {
+        image.append(reinterpret_cast<const char *>(table.data()), table.size() * sizeof(T));
+    }
+}
+
+AnswerGraphFile::AnswerGraphFile()
+{
+    _mapping = nullptr;
+    _mappingSize = 0;
+    _header = nullptr;
+    _nodes = nullptr;
+    _edges = nullptr;
+    _childEdgeOffsets = nullptr;
+    _strings = nullptr;
+    _stringData = nullptr;
+}
+
+AnswerGraphFile::~AnswerGraphFile()
+{
+    Close();
+}
+
+bool AnswerGraphFile::Open(const std::string &filename)
+{
+    Close();
+
+#ifdef MEMBOT_HAVE_MMAP
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        MEMBOT_LOG_ERROR("File could not be opened!");
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        MEMBOT_LOG_ERROR("Error: binary answer graph is empty");
+        return false;
+    }
+
+    void *mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file alive
+    if (mapping == MAP_FAILED)
+    {
+        MEMBOT_LOG_ERROR("Error: binary answer graph could not be mapped");
+        return false;
+    }
+
+    _mapping = mapping;
+    _mappingSize = info.st_size;
+    const char *data = static_cast<const char *>(mapping);
+    size_t size = _mappingSize;
+#else
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        MEMBOT_LOG_ERROR("File could not be opened!");
+        return false;
+    }
+    _buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    const char *data = _buffer.data();
+    size_t size = _buffer.size();
+#endif
+
+    if (!Validate(data, size))
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+bool AnswerGraphFile::OpenImage(const void *data, size_t size)
+{
+    Close();
+
+    // the sections are accessed in place, so the image must be aligned like the tables
+    if (reinterpret_cast<uintptr_t>(data) % alignof(uint32_t) != 0)
+    {
+        MEMBOT_LOG_ERROR("Error: binary answer graph image is not aligned");
+        return false;
+    }
+
+    if (!Validate(static_cast<const char *>(data), size))
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void AnswerGraphFile::Close()
+{
+#ifdef MEMBOT_HAVE_MMAP
+    if (_mapping != nullptr)
+        munmap(_mapping, _mappingSize);
+#endif
+    _mapping = nullptr;
+    _mappingSize = 0;
+    _buffer.clear();
+
+    _header = nullptr;
+    _nodes = nullptr;
+    _edges = nullptr;
+    _childEdgeOffsets = nullptr;
+    _strings = nullptr;
+    _stringData = nullptr;
+}
+
+bool AnswerGraphFile::Validate(const char *data, size_t size)
+{
+    // check header
+    if (size < sizeof(AnswerGraphFileHeader) || std::memcmp(data, kMagic, sizeof(kMagic)) != 0)
+    {
+        MEMBOT_LOG_ERROR("Error: not a binary answer graph");
+        return false;
+    }
+    const AnswerGraphFileHeader *header = reinterpret_cast<const AnswerGraphFileHeader *>(data);
+    if (header->version != kAnswerGraphFileVersion)
+    {
+        MEMBOT_LOG_ERROR("Error: unsupported binary answer graph version " << header->version);
+        return false;
+    }
+    if (ComputeFileSize(*header) != size)
+    {
+        MEMBOT_LOG_ERROR("Error: binary answer graph is truncated");
+        return false;
+    }
+
+    // locate sections
+    const char *pos = data + sizeof(AnswerGraphFileHeader);
+    const AnswerGraphFileNode *nodes = reinterpret_cast<const AnswerGraphFileNode *>(pos);
+    pos += size_t(header->numNodes) * sizeof(AnswerGraphFileNode);
+    const AnswerGraphFileEdge *edges = reinterpret_cast<const AnswerGraphFileEdge *>(pos);
+    pos += size_t(header->numEdges) * sizeof(AnswerGraphFileEdge);
+    const uint32_t *childEdgeOffsets = reinterpret_cast<const uint32_t *>(pos);
+    pos += (size_t(header->numNodes) + 1) * sizeof(uint32_t);
+    const StringRef *strings = reinterpret_cast<const StringRef *>(pos);
+    pos += size_t(header->numStrings) * sizeof(StringRef);
+    const char *stringData = pos;
+
+    // check all references once, so that accessors do not need to
+    for (uint32_t i = 0; i < header->numStrings; ++i)
+    {
+        if (size_t(strings[i].offset) + strings[i].length > header->stringDataSize)
+        {
+            MEMBOT_LOG_ERROR("Error: binary answer graph has an invalid string table");
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header->numNodes; ++i)
+    {
+        if (size_t(nodes[i].firstAnswer) + nodes[i].numAnswers > header->numStrings ||
+            childEdgeOffsets[i] > childEdgeOffsets[i + 1])
+        {
+            MEMBOT_LOG_ERROR("Error: binary answer graph has an invalid node table");
+            return false;
+        }
+    }
+    if (childEdgeOffsets[0] != 0 || childEdgeOffsets[header->numNodes] != header->numEdges)
+    {
+        MEMBOT_LOG_ERROR("Error: binary answer graph has invalid child edge offsets");
+        return false;
+    }
+    for (uint32_t i = 0; i < header->numEdges; ++i)
+    {
+        if (edges[i].parent >= header->numNodes || edges[i].child >= header->numNodes ||
+            size_t(edges[i].firstKeyword) + edges[i].numKeywords > header->numStrings)
+        {
+            MEMBOT_LOG_ERROR("Error: binary answer graph has an invalid edge table");
+            return false;
+        }
+    }
+
+    // the accessors and the routing rely on edges grouped by parent (child edge i of a node has that node as
+    // its parent) and on the number of parents matching the edges, so a corrupt file must not break either
+    std::vector<uint32_t> numParents(header->numNodes, 0);
+    for (uint32_t i = 0; i < header->numNodes; ++i)
+    {
+        for (uint32_t e = childEdgeOffsets[i]; e < childEdgeOffsets[i + 1]; ++e)
+        {
+            if (edges[e].parent != i)
+            {
+                MEMBOT_LOG_ERROR("Error: binary answer graph has edges outside of their parent node");
+                return false;
+            }
+            numParents[edges[e].child]++;
+        }
+    }
+    for (uint32_t i = 0; i < header->numNodes; ++i)
+    {
+        if (nodes[i].numParents != numParents[i])
+        {
+            MEMBOT_LOG_ERROR("Error: binary answer graph has invalid parent counts");
+            return false;
+        }
+    }
+
+    _header = header;
+    _nodes = nodes;
+    _edges = edges;
+    _childEdgeOffsets = childEdgeOffsets;
+    _strings = strings;
+    _stringData = stringData;
+
+    return true;
+}
+
+bool IsAnswerGraphBinaryFile(const std::string &filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    char magic[sizeof(kMagic)];
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool CreateAnswerGraphImage(const GraphRecords &records, std::string &image)
+{
+    std::vector<AnswerGraphFileNode> nodes;
+    std::vector<StringRef> strings;
+    StringPool pool; // equal strings are written once
+
+    auto addString = [&strings, &pool](std::string_view str) { strings.push_back(pool.Intern(str)); };
+
+    // create node table (the first node with a given ID wins, as in the text loader)
+    NodeIndex nodeIndex;
+    if (!records.nodes.empty())
+    {
+        auto range = std::minmax_element(records.nodes.begin(), records.nodes.end(), [](const GraphNodeRecord &a, const GraphNodeRecord &b) { return a.id < b.id; });
+        nodeIndex.Reset(range.first->id, range.second->id, records.nodes.size());
+    }
+    for (const GraphNodeRecord &record : records.nodes)
+    {
+        if (nodeIndex.Insert(record.id, uint32_t(nodes.size())))
+        {
+            nodes.push_back(AnswerGraphFileNode{record.id, uint32_t(strings.size()), uint32_t(record.answers.size()), 0});
+            for (std::string_view answer : record.answers)
+                addString(answer);
+        }
+    }
+
+    // resolve node IDs of all edges
+    std::vector<std::pair<uint32_t, uint32_t>> edgeNodes; // <parent,child> per edge record
+    std::vector<uint32_t> childEdgeOffsets(nodes.size() + 1, 0);
+    for (const GraphEdgeRecord &record : records.edges)
+    {
+        uint32_t parent = nodeIndex.Find(record.parentId);
+        uint32_t child = nodeIndex.Find(record.childId);
+        if (parent == NodeIndex::kNotFound || child == NodeIndex::kNotFound)
+        {
+            MEMBOT_LOG_ERROR("Error: edge " << record.id << " references missing node "
+                             << (parent == NodeIndex::kNotFound ? record.parentId : record.childId));
+            return false;
+        }
+        edgeNodes.emplace_back(parent, child);
+        childEdgeOffsets[parent + 1]++;
+        nodes[child].numParents++;
+    }
+    for (size_t i = 0; i < nodes.size(); ++i)
+        childEdgeOffsets[i + 1] += childEdgeOffsets[i];
+
+    // create edge table grouped by parent node (keeping file order within each group)
+    std::vector<AnswerGraphFileEdge> edges(records.edges.size());
+    std::vector<uint32_t> fill(childEdgeOffsets.begin(), childEdgeOffsets.end() - 1);
+    for (size_t i = 0; i < records.edges.size(); ++i)
+    {
+        const GraphEdgeRecord &record = records.edges[i];
+        edges[fill[edgeNodes[i].first]++] = AnswerGraphFileEdge{record.id, edgeNodes[i].first, edgeNodes[i].second,
+                                                                uint32_t(strings.size()), uint32_t(record.keywords.size()), 0};
+        for (std::string_view keyword : record.keywords)
+            addString(keyword);
+    }
+
+    // append all sections
+    AnswerGraphFileHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kAnswerGraphFileVersion;
+    header.numNodes = nodes.size();
+    header.numEdges = edges.size();
+    header.numStrings = strings.size();
+    header.stringDataSize = pool.GetSize();
+    header.reserved = 0;
+
+    image.assign(reinterpret_cast<const char *>(&header), sizeof(header));
+    image.reserve(ComputeFileSize(header));
+    AppendTable(image, nodes);
+    AppendTable(image, edges);
+    AppendTable(image, childEdgeOffsets);
+    AppendTable(image, strings);
+    image.append(pool.GetData(), pool.GetSize());
+    image.resize(ComputeFileSize(header), '\0');
+
+    return true;
+}
+
+bool WriteAnswerGraphFile(const std::string &filename, const GraphRecords &records)
+{
+    std::string image;
+    if (!CreateAnswerGraphImage(records, image))
+        return false;
+
+    // the graph is written next to the target and renamed over it, because a running program may still
+    // have the old file mapped (e.g. after a hot reload) and truncating it in place would pull its pages away
+    std::string temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            MEMBOT_LOG_ERROR("File could not be opened!");
+            return false;
+        }
+        file.write(image.data(), image.size());
+        file.close();
+        if (!file)
+        {
+            MEMBOT_LOG_ERROR("Error: binary answer graph could not be written");
+            std::error_code error;
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, filename, error);
+    if (error)
+    {
+        MEMBOT_LOG_ERROR("Error: binary answer graph could not be replaced: " << error.message());
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
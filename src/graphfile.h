@@ -0,0 +1,105 @@
+#ifndef GRAPHFILE_H_
+#define GRAPHFILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stringpool.h"
+
+struct GraphRecords; // forward declaration
+
+// Binary answer graph format (native byte order, all sections 4-byte aligned):
+//   header | node table | edge table (grouped by parent node) | child edge offsets (CSR, numNodes + 1) | string table | string data
+// Node and edge references are indices into the respective tables, answers and keywords are
+// contiguous ranges in the string table, so the file can be used in place without any parsing.
+struct AnswerGraphFileHeader
+{
+    char magic[8];           // "MEMBOTG" followed by a zero byte
+    uint32_t version;        // format version, see kAnswerGraphFileVersion
+    uint32_t numNodes;       // entries in the node table
+    uint32_t numEdges;       // entries in the edge table
+    uint32_t numStrings;     // entries in the string table
+    uint32_t stringDataSize; // bytes of string data
+    uint32_t reserved;       // always zero
+};
+
+struct AnswerGraphFileNode
+{
+    int32_t id;           // node ID from the text format
+    uint32_t firstAnswer; // index of the first answer in the string table
+    uint32_t numAnswers;  // number of answers
+    uint32_t numParents;  // number of incoming edges
+};
+
+struct AnswerGraphFileEdge
+{
+    int32_t id;            // edge ID from the text format
+    uint32_t parent;       // index of the parent node in the node table
+    uint32_t child;        // index of the child node in the node table
+    uint32_t firstKeyword; // index of the first keyword in the string table
+    uint32_t numKeywords;  // number of keywords
+    uint32_t reserved;     // always zero
+};
+
+const uint32_t kAnswerGraphFileVersion = 1;
+
+// read-only view of a binary answer graph file, memory-mapped where the platform supports it
+class AnswerGraphFile
+{
+private:
+    // data handles (owned)
+    void *_mapping;           // memory mapping of the whole file
+    size_t _mappingSize;      // size of the mapping in bytes
+    std::vector<char> _buffer; // file contents if memory mapping is not available
+
+    // data handles (not owned, point into the file contents)
+    const AnswerGraphFileHeader *_header;
+    const AnswerGraphFileNode *_nodes;
+    const AnswerGraphFileEdge *_edges;
+    const uint32_t *_childEdgeOffsets;
+    const StringRef *_strings;
+    const char *_stringData;
+
+    // proprietary functions
+    bool Validate(const char *data, size_t size);
+
+public:
+    // constructor / destructor
+    AnswerGraphFile();
+    ~AnswerGraphFile();
+
+    // the mapping is exclusively owned
+    AnswerGraphFile(const AnswerGraphFile &source) = delete;
+    AnswerGraphFile &operator=(const AnswerGraphFile &source) = delete;
+
+    // getter / setter
+    uint32_t GetNumberOfNodes() const { return _header->numNodes; }
+    uint32_t GetNumberOfEdges() const { return _header->numEdges; }
+    const AnswerGraphFileNode &GetNode(uint32_t index) const { return _nodes[index]; }
+    const AnswerGraphFileEdge &GetEdge(uint32_t index) const { return _edges[index]; }
+    uint32_t GetFirstChildEdge(uint32_t node) const { return _childEdgeOffsets[node]; }
+    uint32_t GetEndOfChildEdges(uint32_t node) const { return _childEdgeOffsets[node + 1]; }
+    std::string_view GetString(uint32_t index) const { return std::string_view(_stringData + _strings[index].offset, _strings[index].length); }
+    const StringRef *GetStringRefs() const { return _strings; }
+    const char *GetStringData() const { return _stringData; }
+
+    // proprietary functions
+    bool Open(const std::string &filename); // returns false if the file is missing or malformed
+    bool OpenImage(const void *data, size_t size); // uses an image in memory in place (not copied, must stay alive and 4-byte aligned)
+    void Close();
+};
+
+// checks the magic number at the beginning of the file
+bool IsAnswerGraphBinaryFile(const std::string &filename);
+
+// resolves node IDs (first definition wins) and creates the binary format in memory, returns false on error
+bool CreateAnswerGraphImage(const GraphRecords &records, std::string &image);
+
+// writes the binary format created by CreateAnswerGraphImage to <filename>.tmp and renames it over the file,
+// so that programs which still map the previous file keep reading it intact; returns false on error
+bool WriteAnswerGraphFile(const std::string &filename, const GraphRecords &records);
+
+#endif /* GRAPHFILE_H_ */
@@ -0,0 +1,105 @@
+#include <algorithm>
+
+#include "log.h"
+#include "graphparser.h"
+#include "graphfile.h"
+#include "answergraph.h"
+#include "graphloader.h"
+
+std::unique_ptr<AnswerGraph> CreateAnswerGraphFromRecords(const GraphRecords &records)
+{
+    // string storage before equal strings are merged
+    size_t numChars = 0;
+    for (const GraphNodeRecord &record : records.nodes)
+    {
+        for (std::string_view answer : record.answers)
+            numChars += answer.size();
+    }
+    for (const GraphEdgeRecord &record : records.edges)
+    {
+        for (std::string_view keyword : record.keywords)
+            numChars += keyword.size();
+    }
+
+    auto graph = std::make_unique<AnswerGraph>();
+    graph->Reserve(records.nodes.size(), records.edges.size(), numChars);
+
+    // prepare ID index for the range of node IDs in the file
+    if (!records.nodes.empty())
+    {
+        auto range = std::minmax_element(records.nodes.begin(), records.nodes.end(), [](const GraphNodeRecord &a, const GraphNodeRecord &b) { return a.id < b.id; });
+        graph->PrepareNodeIndex(range.first->id, range.second->id, records.nodes.size());
+    }
+
+    // node-based processing
+    for (const GraphNodeRecord &record : records.nodes)
+    {
+        // create new element if ID does not yet exist
+        GraphNode *node = graph->AddNode(record.id);
+        if (node != nullptr)
+        {
+            // add all answers to current node
+            for (std::string_view answer : record.answers)
+                node->AddToken(answer);
+        }
+    }
+
+    // edge-based processing
+    for (const GraphEdgeRecord &record : records.edges)
+    {
+        // create new edge between incoming and outgoing node (found via ID lookup)
+        GraphEdge *edge = graph->AddEdge(record.id, record.parentId, record.childId);
+        if (edge == nullptr)
+        {
+            MEMBOT_LOG_ERROR("Error: edge " << record.id << " references missing node "
+                             << (graph->FindNode(record.parentId) == nullptr ? record.parentId : record.childId));
+            return nullptr;
+        }
+
+        // add all keywords to current edge
+        for (std::string_view keyword : record.keywords)
+            edge->AddToken(keyword);
+    }
+
+    // group child edges and strings into their final layout
+    if (!graph->Finalize())
+        return nullptr;
+
+    return graph;
+}
+
+std::unique_ptr<AnswerGraph> LoadAnswerGraphImage(const void *data, size_t size)
+{
+    // the same as a memory-mapped binary file, without any file access
+    auto file = std::make_unique<AnswerGraphFile>();
+    if (!file->OpenImage(data, size))
+        return nullptr;
+
+    auto graph = std::make_unique<AnswerGraph>();
+    if (!graph->CreateFromBinaryFile(std::move(file)))
+        return nullptr;
+    return graph;
+}
+
+std::unique_ptr<AnswerGraph> LoadAnswerGraph(const std::string &filename, size_t numThreads)
+{
+    if (IsAnswerGraphBinaryFile(filename))
+    {
+        // binary format as produced by answergraphc, node and edge references are already
+        // resolved to table indices and strings are used in place
+        auto file = std::make_unique<AnswerGraphFile>();
+        if (!file->Open(filename))
+            return nullptr;
+
+        auto graph = std::make_unique<AnswerGraph>();
+        if (!graph->CreateFromBinaryFile(std::move(file)))
+            return nullptr;
+        return graph;
+    }
+
+    // text format: lines are parsed in parallel, the graph is then built from the records in file order
+    GraphRecords records;
+    if (!ParseAnswerGraphFile(filename, records, numThreads))
+        return nullptr;
+    return CreateAnswerGraphFromRecords(records);
+}
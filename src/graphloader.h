@@ -0,0 +1,23 @@
+#ifndef GRAPHLOADER_H_
+#define GRAPHLOADER_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+class AnswerGraph;   // forward declaration
+struct GraphRecords; // forward declaration
+
+// loads an answer graph in text or binary format (detected by the file header),
+// returns nullptr if the file cannot be read or the graph is inconsistent;
+// large text files are parsed on numThreads threads (0 uses all hardware threads)
+std::unique_ptr<AnswerGraph> LoadAnswerGraph(const std::string &filename, size_t numThreads = 0);
+
+// uses a binary answer graph image in place (e.g. one compiled into the executable), which must stay alive
+// as long as the graph, returns nullptr if the image is malformed or the graph is inconsistent
+std::unique_ptr<AnswerGraph> LoadAnswerGraphImage(const void *data, size_t size);
+
+// builds an answer graph from parsed records, returns nullptr if the graph is inconsistent
+std::unique_ptr<AnswerGraph> CreateAnswerGraphFromRecords(const GraphRecords &records);
+
+#endif /* GRAPHLOADER_H_ */
@@ -1,51 +1,44 @@
+#include "rng.h"
+#include "answergraph.h"
 #include "graphedge.h"
 #include "graphnode.h"
 
-#include "chatlogic.h"
-#include <iostream>
-#include <memory>
-
-GraphNode::GraphNode(int id)
+GraphNode::GraphNode(AnswerGraph *graph, int id)
 {
+    _graph = graph;
     _id = id;
+    _firstChildEdge = 0;
+    _numChildEdges = 0;
+    _numParents = 0;
+    _firstAnswer = 0;
+    _numAnswers = 0;
+    _firstMatchEntry = 0;
+    _numMatchEntries = 0;
 }
 
-GraphNode::~GraphNode()
-{
-    //std::cout<< "Deleting chatBot instance in GraphNode Destructor" << std::endl;
-    //delete _chatBot; 
-}
-
-void GraphNode::AddToken(std::string token)
+void GraphNode::AddToken(std::string_view token)
 {
-    _answers.push_back(token);
+    _graph->AddAnswer(this, token);
 }
 
-void GraphNode::AddEdgeToParentNode(GraphEdge *edge)
+StringList GraphNode::GetAnswers() const
 {
-    _parentEdges.push_back(edge);
+    return _graph->GetStrings(_firstAnswer, _numAnswers);
 }
 
-void GraphNode::AddEdgeToChildNode(GraphEdge *edge)
+std::string_view GraphNode::SelectAnswer(Pcg32 &rng) const
 {
-    _childEdges.push_back(std::unique_ptr<GraphEdge>(edge));
+    // select a random node answer (if several answers should exist)
+    StringList answers = GetAnswers();
+    return answers.empty() ? std::string_view() : answers[rng.NextBelow(answers.size())];
 }
 
-// passign an r-value reference as an argument
-void GraphNode::MoveChatbotHere(ChatBot &&chatbot)
+KeywordMatcher GraphNode::GetKeywordMatcher() const
 {
-    _chatBot = std::move(chatbot);
-    //update Chatlogic._chatBot handle that points to ChatBot
-    _chatBot.GetChatLogicHandle()->SetChatbotHandle(&_chatBot);
-    _chatBot.SetCurrentNode(this);
+    return _graph->GetKeywordMatcher(_firstMatchEntry, _numMatchEntries);
 }
 
-void GraphNode::MoveChatbotToNewNode(GraphNode *newNode)
+const GraphEdge *GraphNode::GetChildEdgeAtIndex(int index) const
 {
-    newNode->MoveChatbotHere(std::move(_chatBot));
+    return _graph->GetEdgeAtIndex(_firstChildEdge + index);
 }
-
-GraphEdge *GraphNode::GetChildEdgeAtIndex(int index)
-{
-    return (_childEdges[index]).get();
-}
\ No newline at end of file
@@ -1,50 +1,51 @@
 #ifndef GRAPHNODE_H_
 #define GRAPHNODE_H_
 
-#include <vector>
-#include <string>
+#include <cstdint>
+#include <string_view>
 
-#include "chatbot.h"
-#include <memory>
+#include "keywordmatcher.h"
+#include "stringpool.h"
 
 // forward declarations
+class AnswerGraph;
 class GraphEdge;
+class Pcg32;
 
+// handle to a node stored in the flat node array of an AnswerGraph
 class GraphNode
 {
 private:
-    // data handles (owned)
-    //std::vector<GraphEdge *> _childEdges;  // edges to subsequent nodes
-    std::vector<std::unique_ptr<GraphEdge>> _childEdges;
+    friend class AnswerGraph;
 
     // data handles (not owned)
-    std::vector<GraphEdge *> _parentEdges; // edges to preceding nodes 
-    ChatBot _chatBot; // to support move semantics
+    AnswerGraph *_graph; // graph that stores child edges, answers and keywords
 
     // proprietary members
     int _id;
-    std::vector<std::string> _answers;
+    uint32_t _firstChildEdge;  // child edges are [_firstChildEdge, _firstChildEdge + _numChildEdges) in the edge array
+    uint32_t _numChildEdges;
+    uint32_t _numParents;      // number of incoming edges
+    uint32_t _firstAnswer;     // answers are a range of strings in the graph
+    uint32_t _numAnswers;
+    uint32_t _firstMatchEntry; // keyword matching entries of all child edges
+    uint32_t _numMatchEntries;
 
 public:
-    // constructor / destructor
-    GraphNode(int id);
-    ~GraphNode();
+    // constructor
+    GraphNode(AnswerGraph *graph, int id);
 
     // getter / setter
-    int GetID() { return _id; }
-    int GetNumberOfChildEdges() { return _childEdges.size(); }
-    GraphEdge *GetChildEdgeAtIndex(int index);
-    std::vector<std::string> GetAnswers() { return _answers; }
-    int GetNumberOfParents() { return _parentEdges.size(); }
+    int GetID() const { return _id; }
+    int GetNumberOfChildEdges() const { return _numChildEdges; }
+    const GraphEdge *GetChildEdgeAtIndex(int index) const;
+    StringList GetAnswers() const;
+    int GetNumberOfParents() const { return _numParents; }
+    KeywordMatcher GetKeywordMatcher() const;
+    std::string_view SelectAnswer(Pcg32 &rng) const; // random answer (view into the graph), empty if there is none
 
     // proprietary functions
-    void AddToken(std::string token); // add answers to list
-    void AddEdgeToParentNode(GraphEdge *edge);
-    void AddEdgeToChildNode(GraphEdge *edge);
-
-    void MoveChatbotHere(ChatBot &&chatbot);
-
-    void MoveChatbotToNewNode(GraphNode *newNode);
+    void AddToken(std::string_view token); // add answers to list (while the graph is being built)
 };
 
-#endif /* GRAPHNODE_H_ */
\ No newline at end of file
+#endif /* GRAPHNODE_H_ */
@@ -0,0 +1,209 @@
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <iterator>
+#include <thread>
+
+#include "log.h"
+#include "workstealingpool.h"
+#include "graphparser.h"
+
+namespace
+{
+    // proprietary type definitions
+    typedef std::vector<std::pair<std::string_view, std::string_view>> tokenlist;
+
+    template <typename T>
+    void AddAllTokensToElement(std::string_view tokenID, const tokenlist &tokens, T &element)
+    {
+        // find all occurences for current element
+        for (const auto &token : tokens)
+        {
+            if (token.first == tokenID)
+                element.AddToken(token.second); // add new answer or keyword to element
+        }
+    }
+
+    // returns the info of the first token with the given type or an empty view
+    std::string_view FindToken(std::string_view tokenID, const tokenlist &tokens)
+    {
+        auto token = std::find_if(tokens.begin(), tokens.end(), [&tokenID](const std::pair<std::string_view, std::string_view> &pair) { return pair.first == tokenID; });
+        return token != tokens.end() ? token->second : std::string_view();
+    }
+
+    // converts the info of an ID token, returns false if it is not a number
+    bool ParseID(std::string_view info, int &id)
+    {
+        auto result = std::from_chars(info.data(), info.data() + info.size(), id);
+        return result.ec == std::errc() && !info.empty();
+    }
+
+    // nodes and edges of a part of the file
+    struct ParsedLines
+    {
+        std::vector<GraphNodeRecord> nodes;
+        std::vector<GraphEdgeRecord> edges;
+        std::vector<std::string> errors;
+    };
+
+    // parses all lines of text, problems are collected in file order (the lines are ignored)
+    void ParseLines(std::string_view text, ParsedLines &lines)
+    {
+        tokenlist tokens; // reused for all lines
+
+        // loop over all lines in the text
+        size_t lineStart = 0;
+        while (lineStart < text.size())
+        {
+            size_t lineEnd = text.find('\n', lineStart);
+            if (lineEnd == std::string_view::npos)
+                lineEnd = text.size();
+            std::string_view lineStr = text.substr(lineStart, lineEnd - lineStart);
+            lineStart = lineEnd + 1;
+
+            // extract all tokens from current line in a single pass
+            tokens.clear();
+            size_t pos = 0;
+            while (true)
+            {
+                size_t posTokenFront = lineStr.find('<', pos);
+                if (posTokenFront == std::string_view::npos)
+                    break; // quit loop if no complete token has been found
+                size_t posTokenBack = lineStr.find('>', posTokenFront + 1);
+                if (posTokenBack == std::string_view::npos)
+                    break;
+                std::string_view tokenStr = lineStr.substr(posTokenFront + 1, posTokenBack - posTokenFront - 1);
+
+                // extract token type and info
+                size_t posTokenInfo = tokenStr.find(':');
+                if (posTokenInfo != std::string_view::npos)
+                    tokens.emplace_back(tokenStr.substr(0, posTokenInfo), tokenStr.substr(posTokenInfo + 1));
+
+                // continue behind current token
+                pos = posTokenBack + 1;
+            }
+
+            // process tokens for current line
+            std::string_view type = FindToken("TYPE", tokens);
+            if (type.empty())
+                continue;
+
+            // check for id
+            int id;
+            if (!ParseID(FindToken("ID", tokens), id))
+            {
+                lines.errors.emplace_back("Error: ID missing. Line is ignored!");
+                continue;
+            }
+
+            // node-based processing
+            if (type == "NODE")
+            {
+                GraphNodeRecord node{id, {}};
+
+                // add all answers to current node
+                AddAllTokensToElement("ANSWER", tokens, node);
+                lines.nodes.push_back(std::move(node));
+            }
+
+            // edge-based processing
+            if (type == "EDGE")
+            {
+                // find tokens for incoming (parent) and outgoing (child) node
+                int parentId, childId;
+                if (ParseID(FindToken("PARENT", tokens), parentId) && ParseID(FindToken("CHILD", tokens), childId))
+                {
+                    GraphEdgeRecord edge{id, parentId, childId, {}};
+
+                    // find all keywords for current edge
+                    AddAllTokensToElement("KEYWORD", tokens, edge);
+                    lines.edges.push_back(std::move(edge));
+                }
+            }
+        } // eof loop over all lines in the text
+    }
+}
+
+bool ParseAnswerGraphFile(const std::string &filename, GraphRecords &records, size_t numThreads)
+{
+    // load file with answer graph elements into one buffer
+    // (a directory can be opened as well, but reports a bogus size)
+    std::error_code error;
+    std::ifstream file;
+    if (std::filesystem::is_regular_file(filename, error))
+        file.open(filename, std::ios::binary);
+
+    // check for file availability
+    if (!file.is_open())
+    {
+        MEMBOT_LOG_ERROR("File could not be opened!");
+        return false;
+    }
+
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file ? std::streamoff(file.tellg()) : -1;
+    if (size < 0)
+    {
+        MEMBOT_LOG_ERROR("File could not be opened!");
+        return false;
+    }
+    records.text.resize(size_t(size));
+    file.seekg(0, std::ios::beg);
+    if (size > 0 && !file.read(&records.text[0], size))
+    {
+        MEMBOT_LOG_ERROR("File could not be read!");
+        records.text.clear();
+        return false;
+    }
+
+    ParseAnswerGraphText(records.text, records, numThreads);
+    return true;
+}
+
+void ParseAnswerGraphText(std::string_view text, GraphRecords &records, size_t numThreads)
+{
+    // phase 1: split the text at line boundaries into chunks of at least kMinChunkSize and parse them on all cores
+    // (more chunks than threads, so that a chunk with long lines does not hold up the others)
+    const size_t kMinChunkSize = 1 << 20;
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    size_t numChunks = numThreads > 1 ? std::max<size_t>(1, std::min(4 * numThreads, text.size() / kMinChunkSize)) : 1;
+    numThreads = std::min(numThreads, numChunks);
+
+    std::vector<size_t> bounds(numChunks + 1, text.size());
+    bounds[0] = 0;
+    for (size_t i = 1; i < numChunks; ++i)
+    {
+        size_t lineEnd = text.find('\n', std::max(text.size() * i / numChunks, bounds[i - 1]));
+        bounds[i] = lineEnd != std::string_view::npos ? lineEnd + 1 : text.size();
+    }
+
+    std::vector<ParsedLines> chunks(numChunks);
+    if (numThreads > 1)
+    {
+        WorkStealingPool pool(numThreads);
+        pool.Run(numChunks, [&](size_t chunk, size_t) { ParseLines(text.substr(bounds[chunk], bounds[chunk + 1] - bounds[chunk]), chunks[chunk]); });
+    }
+    else
+        ParseLines(text, chunks[0]);
+
+    // phase 2: append the chunks in file order, so that the graph is built exactly as from a sequential parse
+    size_t numNodes = records.nodes.size(), numEdges = records.edges.size();
+    for (const ParsedLines &chunk : chunks)
+    {
+        numNodes += chunk.nodes.size();
+        numEdges += chunk.edges.size();
+    }
+    records.nodes.reserve(numNodes);
+    records.edges.reserve(numEdges);
+
+    for (ParsedLines &chunk : chunks)
+    {
+        for (const std::string &error : chunk.errors)
+            MEMBOT_LOG_ERROR(error);
+        std::move(chunk.nodes.begin(), chunk.nodes.end(), std::back_inserter(records.nodes));
+        std::move(chunk.edges.begin(), chunk.edges.end(), std::back_inserter(records.edges));
+    }
+}
+
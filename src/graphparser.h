@@ -0,0 +1,45 @@
+#ifndef GRAPHPARSER_H_
+#define GRAPHPARSER_H_
+
+#include <cstddef>
+#include <vector>
+#include <string>
+#include <string_view>
+
+// node as found in the answer graph file (before IDs are resolved)
+struct GraphNodeRecord
+{
+    int id;
+    std::vector<std::string_view> answers; // views into GraphRecords::text
+
+    void AddToken(std::string_view token) { answers.push_back(token); }
+};
+
+// edge as found in the answer graph file (parent and child are node IDs)
+struct GraphEdgeRecord
+{
+    int id;
+    int parentId;
+    int childId;
+    std::vector<std::string_view> keywords; // views into GraphRecords::text
+
+    void AddToken(std::string_view token) { keywords.push_back(token); }
+};
+
+// all elements of an answer graph file in file order
+struct GraphRecords
+{
+    std::string text; // file contents, all views point into it (records must not be moved)
+    std::vector<GraphNodeRecord> nodes;
+    std::vector<GraphEdgeRecord> edges;
+};
+
+// parses the text format (one <TYPE:...><ID:...>... element per line), returns false if the file cannot be opened;
+// large files are split at line boundaries and parsed on numThreads threads (0 uses all hardware threads)
+bool ParseAnswerGraphFile(const std::string &filename, GraphRecords &records, size_t numThreads = 0);
+
+// parses text that is already in memory, all views in records point into text; the records and the
+// reported errors are in file order, no matter how many threads are used
+void ParseAnswerGraphText(std::string_view text, GraphRecords &records, size_t numThreads = 1);
+
+#endif /* GRAPHPARSER_H_ */
@@ -0,0 +1,64 @@
+#include <system_error>
+
+#include "log.h"
+#include "answergraph.h"
+#include "graphloader.h"
+#include "graphwatcher.h"
+
+AnswerGraphWatcher::AnswerGraphWatcher(std::string filename, std::chrono::milliseconds interval, std::function<void(std::unique_ptr<AnswerGraph>)> onReload)
+    : _filename(std::move(filename)), _interval(interval), _onReload(std::move(onReload)), _lastSize(0), _isStopping(false)
+{
+    // remember the current state, so the graph that has just been loaded is not loaded again
+    HasChanged();
+
+    _thread = std::thread(&AnswerGraphWatcher::Run, this);
+}
+
+AnswerGraphWatcher::~AnswerGraphWatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(_wakeMutex);
+        _isStopping = true;
+    }
+    _wakeCondition.notify_one();
+    _thread.join();
+}
+
+bool AnswerGraphWatcher::HasChanged()
+{
+    // a missing file (e.g. while it is being replaced) does not count as a change
+    std::error_code error;
+    std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(_filename, error);
+    if (error)
+        return false;
+    uintmax_t size = std::filesystem::file_size(_filename, error);
+    if (error)
+        return false;
+
+    if (writeTime == _lastWriteTime && size == _lastSize)
+        return false;
+
+    _lastWriteTime = writeTime;
+    _lastSize = size;
+    return true;
+}
+
+void AnswerGraphWatcher::Run()
+{
+    std::unique_lock<std::mutex> lock(_wakeMutex);
+    while (!_wakeCondition.wait_for(lock, _interval, [this] { return _isStopping; }))
+    {
+        if (!HasChanged())
+            continue;
+
+        // the graph is built without holding the lock, so stopping never waits for more than one load
+        lock.unlock();
+        MEMBOT_LOG_INFO("Reloading answer graph " << _filename);
+        std::unique_ptr<AnswerGraph> graph = LoadAnswerGraph(_filename);
+        if (graph != nullptr)
+            _onReload(std::move(graph));
+        else
+            MEMBOT_LOG_ERROR("Error: reloaded answer graph " << _filename << " is not used!");
+        lock.lock();
+    }
+}
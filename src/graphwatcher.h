@@ -0,0 +1,55 @@
+#ifndef GRAPHWATCHER_H_
+#define GRAPHWATCHER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class AnswerGraph; // forward declaration
+
+// watches an answer graph file on a background thread and loads it again (text or binary format)
+// whenever its modification time or size changes. Each successfully loaded graph is passed to the
+// reload callback on the watcher thread, which should only publish it (e.g. with an atomic pointer
+// swap), so that readers of the current graph never wait for a reload. A file that cannot be loaded,
+// e.g. while it is still being written, is skipped until it changes again.
+class AnswerGraphWatcher
+{
+private:
+    // proprietary members
+    std::string _filename;
+    std::chrono::milliseconds _interval;
+    std::function<void(std::unique_ptr<AnswerGraph>)> _onReload;
+    std::filesystem::file_time_type _lastWriteTime; // state of the file when it was last loaded (watcher thread only)
+    uintmax_t _lastSize;
+    bool _isStopping;
+
+    // the watcher sleeps between two checks of the file
+    std::mutex _wakeMutex;
+    std::condition_variable _wakeCondition;
+    std::thread _thread;
+
+    // proprietary functions
+    bool HasChanged();
+    void Run();
+
+public:
+    // constructor / destructor
+    // the file is assumed to be in the state it was loaded from at construction
+    AnswerGraphWatcher(std::string filename, std::chrono::milliseconds interval, std::function<void(std::unique_ptr<AnswerGraph>)> onReload);
+    ~AnswerGraphWatcher(); // joins the watcher thread, a reload in progress is finished first
+
+    // the watcher thread refers to this instance
+    AnswerGraphWatcher(const AnswerGraphWatcher &source) = delete;
+    AnswerGraphWatcher &operator=(const AnswerGraphWatcher &source) = delete;
+
+    // getter / setter
+    const std::string &GetFilename() const { return _filename; }
+};
+
+#endif /* GRAPHWATCHER_H_ */
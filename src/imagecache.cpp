@@ -0,0 +1,20 @@
+
+#include "log.h"
+#include "imagecache.h"
+
+std::unordered_map<std::string, std::weak_ptr<const wxBitmap>> ImageCache::_bitmaps;
+
+std::shared_ptr<const wxBitmap> ImageCache::GetBitmap(const std::string &filename, wxBitmapType type)
+{
+    std::weak_ptr<const wxBitmap> &entry = _bitmaps[filename];
+    if (std::shared_ptr<const wxBitmap> bitmap = entry.lock())
+        return bitmap;
+
+    // decode image, the entry expires together with the last handle
+    auto bitmap = std::make_shared<const wxBitmap>(filename, type);
+    if (!bitmap->IsOk())
+        MEMBOT_LOG_ERROR("Error: image " << filename << " could not be loaded");
+
+    entry = bitmap;
+    return bitmap;
+}
@@ -0,0 +1,26 @@
+#ifndef IMAGECACHE_H_
+#define IMAGECACHE_H_
+
+#include <wx/bitmap.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// process-wide cache of decoded images keyed by file path. Handles are reference counted,
+// an image is decoded on first request and freed as soon as the last handle is released.
+// Like all wxWidgets bitmaps, the cache must only be used from the GUI thread.
+class ImageCache
+{
+private:
+    // proprietary members
+    static std::unordered_map<std::string, std::weak_ptr<const wxBitmap>> _bitmaps;
+
+public:
+    // returns a shared handle, the image is only read from disk if no handle to it exists
+    static std::shared_ptr<const wxBitmap> GetBitmap(const std::string &filename, wxBitmapType type = wxBITMAP_TYPE_PNG);
+
+    // getter / setter
+    static size_t GetNumberOfBitmaps() { return _bitmaps.size(); }
+};
+
+#endif /* IMAGECACHE_H_ */
@@ -0,0 +1,374 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "log.h"
+#include "instrumentation.h"
+
+namespace
+{
+const char *const stageNames[kNumStages] = {"send_message", "edge_scan", "levenshtein", "node_transition", "add_dialog_item", "server_turn"};
+const char *const counterNames[kNumCounters] = {"levenshtein_calls", "levenshtein_cells", "response_cache_hits",
+                                                   "response_cache_misses", "response_cache_evictions", "exact_match_hits"};
+
+// HDR-style histogram of durations in nanoseconds: values below 16 are exact, above that each power of two
+// is split into 16 linear sub-buckets, so every bucket is within 1/16 of its values
+class LatencyHistogram
+{
+private:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kNumBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    std::array<std::atomic<uint64_t>, kNumBuckets> _buckets;
+    std::atomic<uint64_t> _count;
+    std::atomic<uint64_t> _sum;
+    std::atomic<uint64_t> _max;
+
+public:
+    LatencyHistogram() { Reset(); }
+
+    static int GetBucketIndex(uint64_t value)
+    {
+        if (value < uint64_t(kSubBuckets))
+            return int(value);
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - kSubBucketBits;
+        return (shift + 1) * kSubBuckets + int((value >> shift) & (kSubBuckets - 1));
+    }
+
+    static uint64_t GetBucketValue(int index)
+    {
+        if (index < kSubBuckets)
+            return uint64_t(index);
+        int shift = index / kSubBuckets - 1;
+        return uint64_t(kSubBuckets + index % kSubBuckets) << shift;
+    }
+
+    void Record(uint64_t value)
+    {
+        _buckets[GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(value, std::memory_order_relaxed);
+        uint64_t max = _max.load(std::memory_order_relaxed);
+        while (value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+            ;
+    }
+
+    void Reset()
+    {
+        for (auto &bucket : _buckets)
+            bucket.store(0, std::memory_order_relaxed);
+        _count = 0;
+        _sum = 0;
+        _max = 0;
+    }
+
+    uint64_t GetCount() const { return _count.load(std::memory_order_relaxed); }
+    uint64_t GetSum() const { return _sum.load(std::memory_order_relaxed); }
+    uint64_t GetMax() const { return _max.load(std::memory_order_relaxed); }
+
+    // lower bound of the bucket containing the given quantile (0 if the histogram is empty)
+    uint64_t GetQuantile(double quantile) const
+    {
+        uint64_t total = 0;
+        std::array<uint64_t, kNumBuckets> counts;
+        for (int i = 0; i < kNumBuckets; ++i)
+            total += counts[i] = _buckets[i].load(std::memory_order_relaxed);
+        if (total == 0)
+            return 0;
+
+        uint64_t rank = std::max<uint64_t>(1, uint64_t(quantile * total + 0.5));
+        uint64_t seen = 0;
+        for (int i = 0; i < kNumBuckets; ++i)
+        {
+            seen += counts[i];
+            if (seen >= rank)
+                return GetBucketValue(i);
+        }
+        return GetMax();
+    }
+};
+
+const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+const char *const quantileNames[] = {"p50", "p90", "p99", "p999"};
+
+std::array<LatencyHistogram, kNumStages> histograms;
+std::array<std::atomic<uint64_t>, kNumCounters> counters;
+
+// Chrome trace: one buffer per thread, the registry keeps them alive after their thread has ended
+struct TraceEvent
+{
+    InstrumentedStage stage;
+    int64_t start; // nanoseconds since the trace was started
+    int64_t duration;
+};
+
+struct TraceBuffer
+{
+    std::mutex mutex; // only contended while the trace is written
+    std::vector<TraceEvent> events;
+    int threadID;
+};
+
+const size_t maxTraceEventsPerThread = 1 << 20;
+
+std::atomic<bool> isTracing(false);
+std::chrono::steady_clock::time_point traceStart;
+std::mutex traceMutex; // guards the registry and the trace file name
+std::vector<std::shared_ptr<TraceBuffer>> traceBuffers;
+std::string traceFilename;
+
+TraceBuffer &GetTraceBuffer()
+{
+    thread_local std::shared_ptr<TraceBuffer> buffer;
+    if (!buffer)
+    {
+        buffer = std::make_shared<TraceBuffer>();
+        std::lock_guard<std::mutex> lock(traceMutex);
+        buffer->threadID = int(traceBuffers.size()) + 1;
+        traceBuffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+bool WriteFile(const std::string &filename, const std::string &contents)
+{
+    // write next to the target and rename, so readers never see a partial dump
+    std::string temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc | std::ios::binary);
+        if (!file || !(file << contents))
+        {
+            MEMBOT_LOG_ERROR("Error: " << temporary << " could not be written");
+            return false;
+        }
+    }
+    return std::rename(temporary.c_str(), filename.c_str()) == 0;
+}
+
+bool EndsWith(const std::string &str, const std::string &suffix)
+{
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// periodic metrics dump
+class MetricsDumper
+{
+private:
+    std::mutex _mutex;
+    std::condition_variable _stopCondition;
+    std::thread _thread;
+    std::string _filename;
+    std::chrono::milliseconds _interval;
+    bool _isStopping = false;
+
+    void Dump() { WriteFile(_filename, EndsWith(_filename, ".prom") ? FormatMetricsPrometheus() : FormatMetricsJson()); }
+
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (!_stopCondition.wait_for(lock, _interval, [this] { return _isStopping; }))
+            Dump();
+        Dump();
+    }
+
+public:
+    ~MetricsDumper() { Stop(); }
+
+    bool Start(const std::string &filename, std::chrono::milliseconds interval)
+    {
+        Stop();
+        _filename = filename;
+        _interval = std::max(interval, std::chrono::milliseconds(1));
+        _isStopping = false;
+        _thread = std::thread(&MetricsDumper::Run, this);
+        return true;
+    }
+
+    void Stop()
+    {
+        if (!_thread.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _isStopping = true;
+        }
+        _stopCondition.notify_one();
+        _thread.join();
+    }
+};
+
+MetricsDumper &GetMetricsDumper()
+{
+    static MetricsDumper dumper;
+    return dumper;
+}
+
+// stops the exports at process exit
+struct InstrumentationShutdown
+{
+    ~InstrumentationShutdown()
+    {
+        StopChromeTrace();
+        StopMetricsDump();
+    }
+};
+
+void StopExportsAtExit()
+{
+    // the dumper and the log sink are created first, so that they are destroyed after the exports have been stopped
+    GetMetricsDumper();
+    FlushLog();
+    static InstrumentationShutdown shutdown;
+}
+} // namespace
+
+void RecordStageDuration(InstrumentedStage stage, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    int64_t duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    histograms[stage].Record(uint64_t(std::max<int64_t>(duration, 0)));
+
+    if (isTracing.load(std::memory_order_relaxed))
+    {
+        TraceBuffer &buffer = GetTraceBuffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        if (buffer.events.size() < maxTraceEventsPerThread)
+            buffer.events.push_back(TraceEvent{stage, std::chrono::duration_cast<std::chrono::nanoseconds>(start - traceStart).count(), duration});
+    }
+}
+
+void AddToCounter(InstrumentedCounter counter, uint64_t value)
+{
+    counters[counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+std::string FormatMetricsJson()
+{
+    std::ostringstream out;
+    out << "{\"stages\":{";
+    for (int s = 0; s < kNumStages; ++s)
+    {
+        const LatencyHistogram &histogram = histograms[s];
+        out << (s ? "," : "") << "\"" << stageNames[s] << "\":{\"count\":" << histogram.GetCount() << ",\"sum_ns\":" << histogram.GetSum()
+            << ",\"max_ns\":" << histogram.GetMax();
+        for (size_t q = 0; q < std::size(quantiles); ++q)
+            out << ",\"" << quantileNames[q] << "_ns\":" << histogram.GetQuantile(quantiles[q]);
+        out << "}";
+    }
+    out << "},\"counters\":{";
+    for (int c = 0; c < kNumCounters; ++c)
+        out << (c ? "," : "") << "\"" << counterNames[c] << "\":" << counters[c].load(std::memory_order_relaxed);
+    out << "}}\n";
+    return out.str();
+}
+
+std::string FormatMetricsPrometheus()
+{
+    std::ostringstream out;
+    out << "# HELP membot_stage_duration_seconds Duration of the stages of a conversation turn.\n"
+        << "# TYPE membot_stage_duration_seconds summary\n";
+    for (int s = 0; s < kNumStages; ++s)
+    {
+        const LatencyHistogram &histogram = histograms[s];
+        for (size_t q = 0; q < std::size(quantiles); ++q)
+            out << "membot_stage_duration_seconds{stage=\"" << stageNames[s] << "\",quantile=\"" << quantiles[q] << "\"} "
+                << histogram.GetQuantile(quantiles[q]) * 1e-9 << "\n";
+        out << "membot_stage_duration_seconds_sum{stage=\"" << stageNames[s] << "\"} " << histogram.GetSum() * 1e-9 << "\n"
+            << "membot_stage_duration_seconds_count{stage=\"" << stageNames[s] << "\"} " << histogram.GetCount() << "\n";
+    }
+    for (int c = 0; c < kNumCounters; ++c)
+        out << "# TYPE membot_" << counterNames[c] << "_total counter\n"
+            << "membot_" << counterNames[c] << "_total " << counters[c].load(std::memory_order_relaxed) << "\n";
+    return out.str();
+}
+
+void ResetMetrics()
+{
+    for (LatencyHistogram &histogram : histograms)
+        histogram.Reset();
+    for (auto &counter : counters)
+        counter.store(0, std::memory_order_relaxed);
+}
+
+bool StartMetricsDump(const std::string &filename, std::chrono::milliseconds interval)
+{
+    StopExportsAtExit();
+    return GetMetricsDumper().Start(filename, interval);
+}
+
+void StopMetricsDump()
+{
+    GetMetricsDumper().Stop();
+}
+
+bool StartChromeTrace(const std::string &filename)
+{
+    StopExportsAtExit();
+    std::lock_guard<std::mutex> lock(traceMutex);
+    if (isTracing)
+        return false;
+
+    for (auto &buffer : traceBuffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->events.clear();
+    }
+    traceFilename = filename;
+    traceStart = std::chrono::steady_clock::now();
+    isTracing = true;
+    return true;
+}
+
+bool StopChromeTrace()
+{
+    std::lock_guard<std::mutex> lock(traceMutex);
+    if (!isTracing)
+        return false;
+    isTracing = false;
+
+    std::ostringstream out;
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    for (auto &buffer : traceBuffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        for (const TraceEvent &event : buffer->events)
+        {
+            // timestamps are microseconds
+            out << (first ? "" : ",") << "\n{\"name\":\"" << stageNames[event.stage] << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadID
+                << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << event.duration / 1000.0 << "}";
+            first = false;
+        }
+        buffer->events.clear();
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    return WriteFile(traceFilename, out.str());
+}
+
+void ConfigureInstrumentationFromEnvironment()
+{
+    const char *metricsFile = std::getenv("MEMBOT_METRICS_FILE");
+    const char *traceFile = std::getenv("MEMBOT_TRACE_FILE");
+#ifndef MEMBOT_INSTRUMENTATION
+    if (metricsFile || traceFile)
+        MEMBOT_LOG_WARNING("Warning: instrumentation is not compiled in (MEMBOT_ENABLE_INSTRUMENTATION), exports stay empty");
+#endif
+
+    if (metricsFile && *metricsFile)
+    {
+        const char *interval = std::getenv("MEMBOT_METRICS_INTERVAL_MS");
+        StartMetricsDump(metricsFile, std::chrono::milliseconds(interval ? std::strtoll(interval, nullptr, 10) : 10000));
+    }
+    if (traceFile && *traceFile)
+        StartChromeTrace(traceFile);
+}
@@ -0,0 +1,79 @@
+#ifndef INSTRUMENTATION_H_
+#define INSTRUMENTATION_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// stages of a conversation turn with a latency histogram each
+enum InstrumentedStage
+{
+    kStageSendMessage,    // ChatLogic::SendMessageToChatbot, the whole turn
+    kStageEdgeScan,       // keyword matching over the child edges of the current node
+    kStageLevenshtein,    // one edit distance computation
+    kStageNodeTransition, // ChatBot::SetCurrentNode, answer selection and delivery
+    kStageAddDialogItem,  // ChatBotPanelDialog::AddDialogItem
+    kStageServerTurn,     // ChatServer, from a received message to its queued answer
+    kNumStages
+};
+
+// plain event counters
+enum InstrumentedCounter
+{
+    kCounterLevenshteinCalls,
+    kCounterLevenshteinCells, // dynamic programming cells covered (pattern length times text length)
+    kCounterResponseCacheHits,
+    kCounterResponseCacheMisses,
+    kCounterResponseCacheEvictions,
+    kCounterExactMatchHits, // messages routed by the exact keyword tables
+    kNumCounters
+};
+
+// Instrumentation is compiled in with MEMBOT_INSTRUMENTATION only (CMake option MEMBOT_ENABLE_INSTRUMENTATION),
+// otherwise the macros below build to nothing. Recording is lock-free: histograms and counters are arrays of
+// relaxed atomics; while a Chrome trace is active, each thread appends to its own event buffer.
+#ifdef MEMBOT_INSTRUMENTATION
+#define MEMBOT_SCOPED_TIMER(stage) ScopedStageTimer membotScopedTimer(stage)
+#define MEMBOT_COUNT(counter, value) AddToCounter((counter), (value))
+#else
+#define MEMBOT_SCOPED_TIMER(stage) do {} while (false)
+#define MEMBOT_COUNT(counter, value) do {} while (false)
+#endif
+
+// recording
+void RecordStageDuration(InstrumentedStage stage, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+void AddToCounter(InstrumentedCounter counter, uint64_t value);
+
+// measures the lifetime of a scope
+class ScopedStageTimer
+{
+private:
+    InstrumentedStage _stage;
+    std::chrono::steady_clock::time_point _start;
+
+public:
+    explicit ScopedStageTimer(InstrumentedStage stage) : _stage(stage), _start(std::chrono::steady_clock::now()) {}
+    ~ScopedStageTimer() { RecordStageDuration(_stage, _start, std::chrono::steady_clock::now()); }
+
+    ScopedStageTimer(const ScopedStageTimer &source) = delete;
+    ScopedStageTimer &operator=(const ScopedStageTimer &source) = delete;
+};
+
+// export of all histograms (count, sum, max and percentiles) and counters
+std::string FormatMetricsJson();
+std::string FormatMetricsPrometheus();
+void ResetMetrics();
+
+// writes the metrics every interval, in Prometheus text format if the file name ends with ".prom" and as JSON otherwise
+bool StartMetricsDump(const std::string &filename, std::chrono::milliseconds interval);
+void StopMetricsDump(); // writes a last dump
+
+// records every timed scope as a complete event of the Chrome trace event format (chrome://tracing, Perfetto)
+bool StartChromeTrace(const std::string &filename);
+bool StopChromeTrace(); // writes the file
+
+// reads MEMBOT_METRICS_FILE, MEMBOT_METRICS_INTERVAL_MS and MEMBOT_TRACE_FILE and starts the exports they ask for;
+// everything still running is stopped and written at process exit
+void ConfigureInstrumentationFromEnvironment();
+
+#endif /* INSTRUMENTATION_H_ */
@@ -0,0 +1,49 @@
+#include "levenshtein.h"
+#include "tokenindex.h"
+#include "keywordmatcher.h"
+
+KeywordMatcher::KeywordMatcher(const char *buffer, const Entry *entries, size_t numEntries, const KeywordTokenIndex *tokenIndex, uint32_t firstEntry)
+{
+    _buffer = buffer;
+    _entries = entries;
+    _numEntries = numEntries;
+    _tokenIndex = tokenIndex;
+    _firstEntry = firstEntry;
+}
+
+int KeywordMatcher::FindBestEdge(std::string_view message, LevenshteinEngine &engine, int *distance) const
+{
+    // keep a running minimum over all keywords (first keyword wins on equal distance)
+    int bestEdge = -1;
+    int bestDist = 0;
+    for (const Entry *entry = _entries; entry != _entries + _numEntries; ++entry)
+    {
+        std::string_view keyword(_buffer + entry->offset, entry->length);
+        // only a strictly smaller distance can replace the current best edge
+        int dist = bestEdge < 0 ? engine.ComputeDistance(keyword, message)
+                                : engine.ComputeDistanceWithin(keyword, message, bestDist - 1);
+        if (bestEdge < 0 || dist < bestDist)
+        {
+            bestEdge = entry->edgeIndex;
+            bestDist = dist;
+
+            // an exact match cannot be improved upon
+            if (bestDist == 0)
+                break;
+        }
+    }
+
+    if (distance != nullptr)
+        *distance = bestDist;
+
+    return bestEdge;
+}
+
+int KeywordMatcher::FindBestEdgeInWords(std::string_view message, LevenshteinEngine &engine, int *distance) const
+{
+    if (_tokenIndex == nullptr)
+        return -1;
+
+    int entry = _tokenIndex->FindBestEntry(message, _firstEntry, _numEntries, engine, distance);
+    return entry >= 0 ? int(_entries[entry - _firstEntry].edgeIndex) : -1;
+}
@@ -0,0 +1,48 @@
+#ifndef KEYWORDMATCHER_H_
+#define KEYWORDMATCHER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+class KeywordTokenIndex; // forward declaration
+class LevenshteinEngine; // forward declaration
+
+// keywords of all child edges of a node, prepared once when the graph is loaded
+// (the matcher is a view into matching data owned by the answer graph)
+class KeywordMatcher
+{
+public:
+    // proprietary type definitions
+    struct Entry
+    {
+        uint32_t offset;    // position of the normalized keyword in the matching buffer
+        uint32_t length;    // number of characters
+        uint32_t edgeIndex; // index of the child edge the keyword belongs to
+    };
+
+private:
+    // data handles (not owned)
+    const char *_buffer;   // all keywords of the graph normalized with NormalizeText, stored back to back
+    const Entry *_entries; // one entry per keyword of this node, in edge order
+    size_t _numEntries;
+    const KeywordTokenIndex *_tokenIndex; // word index of the whole graph (nullptr if not built)
+    uint32_t _firstEntry;                 // position of the first entry of this node in the word index
+
+public:
+    // constructor
+    KeywordMatcher(const char *buffer, const Entry *entries, size_t numEntries, const KeywordTokenIndex *tokenIndex = nullptr, uint32_t firstEntry = 0);
+
+    // getter / setter
+    size_t GetNumberOfKeywords() const { return _numEntries; }
+
+    // proprietary functions (messages must have been normalized with NormalizeText)
+    // returns the index of the child edge with the closest keyword or -1 if there are no keywords
+    int FindBestEdge(std::string_view message, LevenshteinEngine &engine, int *distance = nullptr) const;
+
+    // returns the index of the child edge with the keyword closest to some words of the message
+    // or -1 if no keyword is close enough (or the word index has not been built)
+    int FindBestEdgeInWords(std::string_view message, LevenshteinEngine &engine, int *distance = nullptr) const;
+};
+
+#endif /* KEYWORDMATCHER_H_ */
@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "instrumentation.h"
+#include "levenshtein.h"
+
+namespace
+{
+    const uint64_t kHighBit = uint64_t(1) << 63;
+
+    // ASCII lower-case conversion, the counterpart of FoldCase
+    inline unsigned char LowerCase(unsigned char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c + ('a' - 'A')) : c;
+    }
+}
+
+LevenshteinEngine::LevenshteinEngine()
+{
+    std::fill(_peq, _peq + 256, 0);
+}
+
+LevenshteinEngine::LevenshteinEngine(const LevenshteinEngine &) : LevenshteinEngine()
+{
+}
+
+LevenshteinEngine &LevenshteinEngine::operator=(const LevenshteinEngine &)
+{
+    // scratch memory is not part of the engine state, so there is nothing to copy
+    return *this;
+}
+
+int LevenshteinEngine::ComputeDistance(std::string_view s1, std::string_view s2)
+{
+    return ComputeDistanceWithin(s1, s2, std::numeric_limits<int>::max());
+}
+
+int LevenshteinEngine::ComputeDistanceWithin(std::string_view s1, std::string_view s2, int maxDist)
+{
+    MEMBOT_SCOPED_TIMER(kStageLevenshtein);
+    MEMBOT_COUNT(kCounterLevenshteinCalls, 1);
+
+    if (maxDist < 0)
+        return maxDist + 1;
+
+    // the distance is symmetric, so the shorter string is used as the bit-parallel pattern
+    std::string_view pattern = s1.size() <= s2.size() ? s1 : s2;
+    std::string_view text = s1.size() <= s2.size() ? s2 : s1;
+
+    // the distance is at least the difference in length
+    if (text.size() - pattern.size() > size_t(maxDist))
+        return maxDist + 1;
+
+    if (pattern.size() == 0)
+        return text.size();
+
+    MEMBOT_COUNT(kCounterLevenshteinCells, pattern.size() * text.size());
+    if (pattern.size() <= 64)
+        return ComputeSingleWord(pattern, text, maxDist);
+
+    return ComputeBlocked(pattern, text, maxDist);
+}
+
+int LevenshteinEngine::ComputeSingleWord(std::string_view pattern, std::string_view text, int maxDist)
+{
+    const size_t m = pattern.size();
+
+    // set up the match mask for each character of the pattern in both cases,
+    // so the characters of the text can be looked up as they are
+    for (size_t i = 0; i < m; ++i)
+    {
+        _peq[FoldCase(pattern[i])] |= uint64_t(1) << i;
+        _peq[LowerCase(pattern[i])] |= uint64_t(1) << i;
+    }
+
+    // vertical deltas of the first column are all +1
+    uint64_t pv = m == 64 ? ~uint64_t(0) : (uint64_t(1) << m) - 1;
+    uint64_t mv = 0;
+    const uint64_t lastBit = uint64_t(1) << (m - 1);
+    int score = m;
+
+    // the bottom cell changes by at most one per column, so the final score is at least
+    // the current score minus the number of remaining columns
+    int remaining = text.size();
+
+    for (char c : text)
+    {
+        uint64_t eq = _peq[static_cast<unsigned char>(c)];
+        uint64_t xv = eq | mv;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+
+        // track the value of the bottom cell in the current column
+        if (ph & lastBit)
+            ++score;
+        else if (mh & lastBit)
+            --score;
+
+        // horizontal delta in the first row is always +1
+        ph = (ph << 1) | 1;
+        mh = mh << 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+
+        if (score - --remaining > maxDist)
+        {
+            score = maxDist + 1;
+            break;
+        }
+    }
+
+    // restore the all-zero state of the match masks
+    for (size_t i = 0; i < m; ++i)
+    {
+        _peq[FoldCase(pattern[i])] = 0;
+        _peq[LowerCase(pattern[i])] = 0;
+    }
+
+    return score;
+}
+
+int LevenshteinEngine::ComputeBlocked(std::string_view pattern, std::string_view text, int maxDist)
+{
+    const size_t m = pattern.size();
+    const size_t blocks = (m + 63) / 64;
+
+    // grow scratch memory (only happens when a longer pattern than ever before is seen)
+    if (_blockPeq.size() < blocks * 256)
+        _blockPeq.resize(blocks * 256, 0);
+    if (_blockPv.size() < blocks)
+    {
+        _blockPv.resize(blocks);
+        _blockMv.resize(blocks);
+    }
+
+    // match masks are stored per character, with one word for each block
+    for (size_t i = 0; i < m; ++i)
+    {
+        _blockPeq[FoldCase(pattern[i]) * blocks + i / 64] |= uint64_t(1) << (i % 64);
+        _blockPeq[LowerCase(pattern[i]) * blocks + i / 64] |= uint64_t(1) << (i % 64);
+    }
+
+    std::fill(_blockPv.begin(), _blockPv.begin() + blocks, ~uint64_t(0));
+    std::fill(_blockMv.begin(), _blockMv.begin() + blocks, 0);
+    const uint64_t lastBit = uint64_t(1) << ((m - 1) % 64);
+    int score = m;
+    int remaining = text.size();
+
+    for (char c : text)
+    {
+        const uint64_t *peq = &_blockPeq[static_cast<unsigned char>(c) * blocks];
+
+        // horizontal delta entering the top block is always +1
+        int carry = 1;
+        for (size_t b = 0; b < blocks; ++b)
+        {
+            uint64_t pv = _blockPv[b];
+            uint64_t mv = _blockMv[b];
+            uint64_t eq = peq[b];
+
+            uint64_t xv = eq | mv;
+            if (carry < 0)
+                eq |= 1;
+            uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            uint64_t ph = mv | ~(xh | pv);
+            uint64_t mh = pv & xh;
+
+            // horizontal delta leaving this block (the last block is only partially used)
+            const uint64_t outBit = b + 1 == blocks ? lastBit : kHighBit;
+            int carryOut = (ph & outBit) ? 1 : ((mh & outBit) ? -1 : 0);
+
+            ph <<= 1;
+            mh <<= 1;
+            if (carry < 0)
+                mh |= 1;
+            else if (carry > 0)
+                ph |= 1;
+
+            _blockPv[b] = mh | ~(xv | ph);
+            _blockMv[b] = ph & xv;
+            carry = carryOut;
+        }
+
+        score += carry;
+
+        if (score - --remaining > maxDist)
+        {
+            score = maxDist + 1;
+            break;
+        }
+    }
+
+    // restore the all-zero state of the match masks
+    for (size_t i = 0; i < m; ++i)
+    {
+        _blockPeq[FoldCase(pattern[i]) * blocks + i / 64] = 0;
+        _blockPeq[LowerCase(pattern[i]) * blocks + i / 64] = 0;
+    }
+
+    return score;
+}
+
+int LevenshteinEngine::ComputeDistanceReference(std::string_view s1, std::string_view s2)
+{
+    // compute Levenshtein distance measure between both strings (compared in upper-case)
+    const size_t m(s1.size());
+    const size_t n(s2.size());
+
+    if (m == 0)
+        return n;
+    if (n == 0)
+        return m;
+
+    std::vector<size_t> costs(n + 1);
+
+    for (size_t k = 0; k <= n; k++)
+        costs[k] = k;
+
+    size_t i = 0;
+    for (std::string_view::const_iterator it1 = s1.begin(); it1 != s1.end(); ++it1, ++i)
+    {
+        costs[0] = i + 1;
+        size_t corner = i;
+
+        size_t j = 0;
+        for (std::string_view::const_iterator it2 = s2.begin(); it2 != s2.end(); ++it2, ++j)
+        {
+            size_t upper = costs[j + 1];
+            if (FoldCase(*it1) == FoldCase(*it2))
+            {
+                costs[j + 1] = corner;
+            }
+            else
+            {
+                size_t t(upper < corner ? upper : corner);
+                costs[j + 1] = (costs[j] < t ? costs[j] : t) + 1;
+            }
+
+            corner = upper;
+        }
+    }
+
+    return costs[n];
+}
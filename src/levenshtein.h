@@ -0,0 +1,50 @@
+#ifndef LEVENSHTEIN_H_
+#define LEVENSHTEIN_H_
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Case-insensitive Levenshtein distance between two strings.
+// Patterns of up to 64 characters are processed with the bit-parallel algorithm by Myers
+// in the formulation of Hyyroe, longer patterns with the blocked variant of the same algorithm.
+// All scratch memory is owned by the engine and reused, so a warmed-up engine does not allocate.
+class LevenshteinEngine
+{
+private:
+    // scratch memory (reused between calls, all entries are zero between calls)
+    uint64_t _peq[256];               // match masks for patterns of up to 64 characters
+    std::vector<uint64_t> _blockPeq;  // match masks for longer patterns, 256 entries per block
+    std::vector<uint64_t> _blockPv;   // positive vertical deltas per block
+    std::vector<uint64_t> _blockMv;   // negative vertical deltas per block
+
+    // proprietary functions
+    int ComputeSingleWord(std::string_view pattern, std::string_view text, int maxDist);
+    int ComputeBlocked(std::string_view pattern, std::string_view text, int maxDist);
+
+public:
+    // constructor
+    LevenshteinEngine();
+
+    // copying an engine only creates new scratch memory
+    LevenshteinEngine(const LevenshteinEngine &source);
+    LevenshteinEngine &operator=(const LevenshteinEngine &source);
+
+    // proprietary functions
+    int ComputeDistance(std::string_view s1, std::string_view s2);
+
+    // returns the distance if it does not exceed maxDist and any value larger than maxDist otherwise,
+    // which allows the computation to stop as soon as the bound can no longer be met
+    int ComputeDistanceWithin(std::string_view s1, std::string_view s2, int maxDist);
+
+    // reference implementation (full dynamic programming matrix, one row at a time)
+    static int ComputeDistanceReference(std::string_view s1, std::string_view s2);
+};
+
+// ASCII upper-case conversion as done by ::toupper in the "C" locale
+inline unsigned char FoldCase(unsigned char c)
+{
+    return (c >= 'a' && c <= 'z') ? static_cast<unsigned char>(c - ('a' - 'A')) : c;
+}
+
+#endif /* LEVENSHTEIN_H_ */
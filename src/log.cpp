@@ -0,0 +1,112 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+#include "log.h"
+
+namespace
+{
+// buffered sink: callers only append to a string, a background thread does the (slow) console output
+class LogSink
+{
+private:
+    // proprietary members
+    std::mutex _mutex;
+    std::condition_variable _wakeCondition;  // wakes the writer thread
+    std::condition_variable _flushCondition; // wakes threads waiting in Flush
+    std::string _buffer;                     // messages not yet taken by the writer thread
+    unsigned long long _written;             // number of messages appended so far
+    unsigned long long _flushed;             // number of messages written to stderr
+    bool _isUrgent;                          // an error or a Flush waits for the writer thread
+    bool _isStopping;
+    std::thread _thread;
+
+    // proprietary functions
+    void Run()
+    {
+        std::string output;
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true)
+        {
+            _wakeCondition.wait_for(lock, std::chrono::milliseconds(100), [this] { return _isStopping || _isUrgent || _buffer.size() >= kBatchSize; });
+
+            unsigned long long written = _written;
+            output.swap(_buffer);
+            _isUrgent = false;
+            bool isStopping = _isStopping;
+
+            lock.unlock();
+            if (!output.empty())
+            {
+                std::fwrite(output.data(), 1, output.size(), stderr);
+                std::fflush(stderr);
+                output.clear();
+            }
+            lock.lock();
+
+            _flushed = written;
+            _flushCondition.notify_all();
+            if (isStopping && _buffer.empty())
+                return;
+        }
+    }
+
+public:
+    static constexpr size_t kBatchSize = 4096;
+
+    LogSink() : _written(0), _flushed(0), _isUrgent(false), _isStopping(false)
+    {
+        _thread = std::thread(&LogSink::Run, this);
+    }
+
+    ~LogSink()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _isStopping = true;
+        }
+        _wakeCondition.notify_one();
+        _thread.join();
+    }
+
+    void Write(int level, const std::string &message)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _buffer.append(message);
+        _buffer.push_back('\n');
+        _written++;
+        if (level >= MEMBOT_LOG_LEVEL_ERROR)
+            _isUrgent = true;
+        if (_isUrgent || _buffer.size() >= kBatchSize)
+            _wakeCondition.notify_one();
+    }
+
+    void Flush()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        unsigned long long target = _written;
+        _isUrgent = true;
+        _wakeCondition.notify_one();
+        _flushCondition.wait(lock, [this, target] { return _flushed >= target; });
+    }
+};
+
+LogSink &GetLogSink()
+{
+    // created on first use, so that builds without enabled log levels never start the thread
+    static LogSink sink;
+    return sink;
+}
+} // namespace
+
+void WriteLogMessage(int level, std::string message)
+{
+    GetLogSink().Write(level, message);
+}
+
+void FlushLog()
+{
+    GetLogSink().Flush();
+}
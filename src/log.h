@@ -0,0 +1,47 @@
+#ifndef LOG_H_
+#define LOG_H_
+
+#include <sstream>
+#include <string>
+
+// log levels, messages below MEMBOT_LOG_LEVEL are removed at compile time
+#define MEMBOT_LOG_LEVEL_DEBUG 0
+#define MEMBOT_LOG_LEVEL_INFO 1
+#define MEMBOT_LOG_LEVEL_WARNING 2
+#define MEMBOT_LOG_LEVEL_ERROR 3
+#define MEMBOT_LOG_LEVEL_OFF 4
+
+// release builds keep errors only, unless the level is set explicitly (e.g. -DMEMBOT_LOG_LEVEL=4)
+#ifndef MEMBOT_LOG_LEVEL
+#ifdef NDEBUG
+#define MEMBOT_LOG_LEVEL MEMBOT_LOG_LEVEL_ERROR
+#else
+#define MEMBOT_LOG_LEVEL MEMBOT_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+// the message is only formatted if its level is enabled, disabled levels build to nothing
+#define MEMBOT_LOG(level, message)                   \
+    do                                               \
+    {                                                \
+        if ((level) >= MEMBOT_LOG_LEVEL)             \
+        {                                            \
+            std::ostringstream logStream;            \
+            logStream << message;                    \
+            WriteLogMessage((level), logStream.str()); \
+        }                                            \
+    } while (false)
+
+#define MEMBOT_LOG_DEBUG(message) MEMBOT_LOG(MEMBOT_LOG_LEVEL_DEBUG, message)
+#define MEMBOT_LOG_INFO(message) MEMBOT_LOG(MEMBOT_LOG_LEVEL_INFO, message)
+#define MEMBOT_LOG_WARNING(message) MEMBOT_LOG(MEMBOT_LOG_LEVEL_WARNING, message)
+#define MEMBOT_LOG_ERROR(message) MEMBOT_LOG(MEMBOT_LOG_LEVEL_ERROR, message)
+
+// appends a message to the log buffer, which is written to stderr by a background thread
+// (errors wake the thread immediately, everything else is written in batches)
+void WriteLogMessage(int level, std::string message);
+
+// blocks until all messages written so far have reached stderr
+void FlushLog();
+
+#endif /* LOG_H_ */
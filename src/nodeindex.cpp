@@ -0,0 +1,72 @@
+#include "nodeindex.h"
+
+NodeIndex::NodeIndex()
+{
+    _isDense = false;
+    _minId = 0;
+}
+
+void NodeIndex::Reset(int minId, int maxId, size_t numNodes)
+{
+    Clear();
+
+    // a dense vector pays off as long as at least every fourth slot is used
+    int64_t range = int64_t(maxId) - int64_t(minId) + 1;
+    _isDense = numNodes > 0 && range > 0 && range <= int64_t(numNodes) * 4;
+    if (_isDense)
+    {
+        _minId = minId;
+        _dense.assign(range, kNotFound);
+    }
+    else
+    {
+        _sparse.reserve(numNodes);
+    }
+}
+
+bool NodeIndex::Insert(int id, uint32_t position)
+{
+    if (_isDense)
+    {
+        int64_t slot = int64_t(id) - _minId;
+        if (slot < 0 || slot >= int64_t(_dense.size()))
+        {
+            // ID outside the announced range, switch to the hash map
+            for (size_t i = 0; i < _dense.size(); ++i)
+            {
+                if (_dense[i] != kNotFound)
+                    _sparse.emplace(int(int64_t(i) + _minId), _dense[i]);
+            }
+            _dense.clear();
+            _isDense = false;
+            return _sparse.emplace(id, position).second;
+        }
+
+        if (_dense[slot] != kNotFound)
+            return false;
+        _dense[slot] = position;
+        return true;
+    }
+
+    return _sparse.emplace(id, position).second;
+}
+
+uint32_t NodeIndex::Find(int id) const
+{
+    if (_isDense)
+    {
+        int64_t slot = int64_t(id) - _minId;
+        return (slot < 0 || slot >= int64_t(_dense.size())) ? kNotFound : _dense[slot];
+    }
+
+    auto it = _sparse.find(id);
+    return it == _sparse.end() ? kNotFound : it->second;
+}
+
+void NodeIndex::Clear()
+{
+    _isDense = false;
+    _minId = 0;
+    _dense.clear();
+    _sparse.clear();
+}
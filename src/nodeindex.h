@@ -0,0 +1,33 @@
+#ifndef NODEINDEX_H_
+#define NODEINDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// maps node IDs to positions in a node container
+// IDs from a compact range are stored in a dense vector, all others in a hash map
+class NodeIndex
+{
+private:
+    // proprietary members
+    bool _isDense;
+    int _minId;
+    std::vector<uint32_t> _dense;               // position per (id - _minId) or kNotFound
+    std::unordered_map<int, uint32_t> _sparse; // position per id
+
+public:
+    static constexpr uint32_t kNotFound = UINT32_MAX;
+
+    // constructor
+    NodeIndex();
+
+    // proprietary functions
+    void Reset(int minId, int maxId, size_t numNodes); // choose the representation for the expected IDs
+    bool Insert(int id, uint32_t position);             // returns false if the ID exists already
+    uint32_t Find(int id) const;                        // returns kNotFound for unknown IDs
+    void Clear();
+};
+
+#endif /* NODEINDEX_H_ */
@@ -0,0 +1,124 @@
+#include <functional>
+
+#include "instrumentation.h"
+#include "responsecache.h"
+
+ResponseCache::ResponseCache(size_t capacity)
+{
+    size_t slotsPerShard = capacity > 0 ? (capacity + kNumShards - 1) / kNumShards : 1;
+    _capacity = slotsPerShard * kNumShards;
+
+    // all memory is allocated up front, apart from the index nodes and long messages
+    for (Shard &shard : _shards)
+    {
+        shard.slots.resize(slotsPerShard, Slot{0, 0, std::string(), Route{-1, -1}, false, false});
+        shard.index.reserve(slotsPerShard);
+        shard.hand = 0;
+    }
+}
+
+uint64_t ResponseCache::Hash(uint32_t node, std::string_view message)
+{
+    // mix the node into the string hash (finalizer of splitmix64), so that all bits take part in the shard selection
+    uint64_t hash = std::hash<std::string_view>()(message) ^ (uint64_t(node) * 0x9E3779B97F4A7C15ull);
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+    return hash ^ (hash >> 31);
+}
+
+size_t ResponseCache::GetNumberOfEntries()
+{
+    size_t count = 0;
+    for (Shard &shard : _shards)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        count += shard.index.size();
+    }
+    return count;
+}
+
+bool ResponseCache::Find(uint32_t node, std::string_view normalizedMessage, Route &route)
+{
+    if (normalizedMessage.size() > kMaxMessageLength)
+        return false;
+
+    uint64_t hash = Hash(node, normalizedMessage);
+    Shard &shard = GetShard(hash);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(hash);
+        if (it != shard.index.end())
+        {
+            // different keys with the same hash share a slot, the key decides
+            Slot &slot = shard.slots[it->second];
+            if (slot.node == node && slot.message == normalizedMessage)
+            {
+                slot.isReferenced = true;
+                route = slot.route;
+                MEMBOT_COUNT(kCounterResponseCacheHits, 1);
+                return true;
+            }
+        }
+    }
+
+    MEMBOT_COUNT(kCounterResponseCacheMisses, 1);
+    return false;
+}
+
+void ResponseCache::Insert(uint32_t node, std::string_view normalizedMessage, const Route &route)
+{
+    if (normalizedMessage.size() > kMaxMessageLength)
+        return;
+
+    uint64_t hash = Hash(node, normalizedMessage);
+    Shard &shard = GetShard(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    // a slot with the same hash is overwritten (another thread may have inserted the same key meanwhile)
+    uint32_t victim;
+    auto it = shard.index.find(hash);
+    if (it != shard.index.end())
+        victim = it->second;
+    else
+    {
+        // CLOCK: entries referenced since the last sweep get a second chance
+        while (shard.slots[shard.hand].isUsed && shard.slots[shard.hand].isReferenced)
+        {
+            shard.slots[shard.hand].isReferenced = false;
+            shard.hand = (shard.hand + 1) % shard.slots.size();
+        }
+        victim = uint32_t(shard.hand);
+        shard.hand = (shard.hand + 1) % shard.slots.size();
+
+        if (shard.slots[victim].isUsed)
+        {
+            shard.index.erase(shard.slots[victim].hash);
+            MEMBOT_COUNT(kCounterResponseCacheEvictions, 1);
+        }
+        shard.index.emplace(hash, victim);
+    }
+
+    // a new entry starts unreferenced, so it is evicted on the next sweep unless it is hit before
+    Slot &slot = shard.slots[victim];
+    slot.hash = hash;
+    slot.node = node;
+    slot.message.assign(normalizedMessage.data(), normalizedMessage.size());
+    slot.route = route;
+    slot.isUsed = true;
+    slot.isReferenced = false;
+}
+
+void ResponseCache::Clear()
+{
+    for (Shard &shard : _shards)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (Slot &slot : shard.slots)
+        {
+            slot.isUsed = false;
+            slot.isReferenced = false;
+        }
+        shard.index.clear();
+        shard.hand = 0;
+    }
+}
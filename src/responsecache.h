@@ -0,0 +1,78 @@
+#ifndef RESPONSECACHE_H_
+#define RESPONSECACHE_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Bounded cache of routing decisions, keyed by the index of the current node and the normalized
+// message. Keyword matching depends on nothing else, so a hit returns exactly what the Levenshtein
+// scan would select, without computing any distance. Entries are replaced with the CLOCK algorithm:
+// a hit only sets a reference bit, and the hand sweeping over the slots evicts the first entry whose
+// bit is clear (clearing the bits it passes). The slots are split into shards with a mutex each, so
+// concurrent conversations rarely wait for each other.
+// All public functions may be called from several threads at once.
+class ResponseCache
+{
+public:
+    // proprietary type definitions
+    struct Route
+    {
+        int edgeIndex; // index among the child edges of the node, -1 for the root node fallback
+        int distance;  // Levenshtein distance of the selected keyword, -1 for the root node fallback
+    };
+
+    static constexpr size_t kMaxMessageLength = 256; // longer messages are neither looked up nor stored
+
+private:
+    struct Slot
+    {
+        uint64_t hash;
+        uint32_t node;
+        std::string message; // keeps its capacity when the slot is reused
+        Route route;
+        bool isUsed;
+        bool isReferenced; // set by a hit, cleared by the passing hand
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::vector<Slot> slots;
+        std::unordered_map<uint64_t, uint32_t> index; // hash of every used slot -> slot
+        size_t hand;
+    };
+    static constexpr size_t kNumShards = 16;
+
+    // proprietary members
+    std::array<Shard, kNumShards> _shards;
+    size_t _capacity;
+
+    // proprietary functions
+    static uint64_t Hash(uint32_t node, std::string_view message);
+    Shard &GetShard(uint64_t hash) { return _shards[hash >> 60]; } // the low bits are used by the index
+
+public:
+    // constructor
+    explicit ResponseCache(size_t capacity); // rounded up to a multiple of the number of shards
+
+    // the shards hold mutexes
+    ResponseCache(const ResponseCache &source) = delete;
+    ResponseCache &operator=(const ResponseCache &source) = delete;
+
+    // getter / setter
+    size_t GetCapacity() const { return _capacity; }
+    size_t GetNumberOfEntries();
+
+    // proprietary functions
+    bool Find(uint32_t node, std::string_view normalizedMessage, Route &route); // returns false on a miss
+    void Insert(uint32_t node, std::string_view normalizedMessage, const Route &route);
+    void Clear();
+};
+
+#endif /* RESPONSECACHE_H_ */
@@ -0,0 +1,79 @@
+#ifndef RNG_H_
+#define RNG_H_
+
+#include <cstdint>
+#include <random>
+
+// PCG32 random number generator (O'Neill, pcg-random.org): 16 bytes of state, cheap to seed,
+// and usable with the standard distributions (UniformRandomBitGenerator)
+class Pcg32
+{
+private:
+    // proprietary members
+    uint64_t _state;
+    uint64_t _increment; // selects one of 2^63 independent streams, always odd
+
+public:
+    // proprietary type definitions
+    typedef uint32_t result_type;
+
+    // constructor
+    explicit Pcg32(uint64_t seed = 0x853c49e6748fea9bull, uint64_t stream = 0xda3e39cb94b95bdbull) { Seed(seed, stream); }
+
+    // proprietary functions
+    void Seed(uint64_t seed, uint64_t stream = 0xda3e39cb94b95bdbull)
+    {
+        _state = 0;
+        _increment = (stream << 1u) | 1u;
+        (*this)();
+        _state += seed;
+        (*this)();
+    }
+
+    // the whole state, e.g. to continue the sequence in another process
+    uint64_t GetState() const { return _state; }
+    uint64_t GetIncrement() const { return _increment; }
+    void SetState(uint64_t state, uint64_t increment)
+    {
+        _state = state;
+        _increment = increment | 1u;
+    }
+
+    result_type operator()()
+    {
+        uint64_t old = _state;
+        _state = old * 6364136223846793005ull + _increment;
+        uint32_t xorshifted = uint32_t(((old >> 18u) ^ old) >> 27u);
+        uint32_t rot = uint32_t(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((-rot) & 31u));
+    }
+
+    // uniformly distributed number in [0, bound), bound must not be zero (Lemire's multiply-shift method)
+    uint32_t NextBelow(uint32_t bound)
+    {
+        uint64_t product = uint64_t((*this)()) * bound;
+        uint32_t low = uint32_t(product);
+        if (low < bound)
+        {
+            uint32_t threshold = uint32_t(-bound) % bound;
+            while (low < threshold)
+            {
+                product = uint64_t((*this)()) * bound;
+                low = uint32_t(product);
+            }
+        }
+        return uint32_t(product >> 32);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT32_MAX; }
+
+    // non-deterministic seed, for generators which do not need to be reproducible
+    static uint64_t RandomSeed()
+    {
+        std::random_device device;
+        return (uint64_t(device()) << 32) | device();
+    }
+};
+
+#endif /* RNG_H_ */
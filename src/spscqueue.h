@@ -0,0 +1,64 @@
+#ifndef SPSCQUEUE_H_
+#define SPSCQUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// bounded lock-free queue for exactly one producer thread and one consumer thread
+// (ring buffer with a power-of-two number of slots, indices only ever increase)
+template <typename T>
+class SpscQueue
+{
+private:
+    // proprietary members
+    std::vector<T> _slots;
+    size_t _mask;
+    alignas(64) std::atomic<size_t> _head; // next slot to read, written by the consumer only
+    alignas(64) std::atomic<size_t> _tail; // next slot to write, written by the producer only
+
+public:
+    // constructor / destructor
+    explicit SpscQueue(size_t capacity) : _head(0), _tail(0)
+    {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        _slots.resize(size);
+        _mask = size - 1;
+    }
+
+    // the queue is shared by reference between two threads
+    SpscQueue(const SpscQueue &source) = delete;
+    SpscQueue &operator=(const SpscQueue &source) = delete;
+
+    // producer: returns false (and leaves value untouched) if the queue is full
+    bool TryPush(T &&value)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) == _slots.size())
+            return false;
+
+        _slots[tail & _mask] = std::move(value);
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer: returns false if the queue is empty
+    bool TryPop(T &value)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire))
+            return false;
+
+        value = std::move(_slots[head & _mask]);
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer: whether there is nothing to pop right now
+    bool IsEmpty() const { return _head.load(std::memory_order_relaxed) == _tail.load(std::memory_order_acquire); }
+};
+
+#endif /* SPSCQUEUE_H_ */
@@ -0,0 +1,118 @@
+#include <functional>
+#include <stdexcept>
+
+#include "stringpool.h"
+
+StringRef StringPool::Add(std::string_view str)
+{
+    StringRef ref{uint32_t(_chars.size()), uint32_t(str.size())};
+    _chars.append(str.data(), str.size());
+    return ref;
+}
+
+uint64_t StringPool::Hash(std::string_view str)
+{
+    return std::hash<std::string_view>()(str);
+}
+
+StringRef StringPool::Intern(std::string_view str)
+{
+    return Intern(str, Hash(str));
+}
+
+void StringPool::Intern(const StringPool &source, StringRef *refs, size_t count, std::vector<uint64_t> *hashes)
+{
+    Reserve(GetSize() + source.GetSize(), _numInterned + count);
+    std::vector<uint64_t> computed;
+    std::vector<uint64_t> &stringHashes = hashes != nullptr ? *hashes : computed;
+    stringHashes.resize(count);
+    for (size_t i = 0; i < count; ++i)
+        stringHashes[i] = Hash(source.Get(refs[i]));
+
+    // the table slots are scattered over memory, so they are prefetched a few strings ahead
+    const size_t kPrefetchDistance = 8;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (i + kPrefetchDistance < count)
+            __builtin_prefetch(&_internSlots[GetInternSlot(stringHashes[i + kPrefetchDistance])]);
+        refs[i] = Intern(source.Get(refs[i]), stringHashes[i]);
+    }
+}
+
+StringRef StringPool::Intern(std::string_view str, uint64_t hash)
+{
+    if (2 * (_numInterned + 1) > _internSlots.size())
+        GrowInternTable(_internSlots.empty() ? 64 : 2 * _internSlots.size());
+
+    size_t mask = _internSlots.size() - 1;
+    for (size_t slot = GetInternSlot(hash);; slot = (slot + 1) & mask)
+    {
+        InternSlot &entry = _internSlots[slot];
+        if (entry.ref.length == kEmptySlot)
+        {
+            entry.hash = hash;
+            entry.ref = Add(str);
+            ++_numInterned;
+            return entry.ref;
+        }
+        if (entry.hash == hash && Get(entry.ref) == str)
+            return entry.ref;
+    }
+}
+
+void StringPool::Reserve(size_t numChars, size_t numInterned)
+{
+    _chars.reserve(numChars);
+
+    // the table is kept at most half full
+    size_t numSlots = 64;
+    while (numSlots < 2 * numInterned)
+        numSlots *= 2;
+    if (numSlots > _internSlots.size() && numInterned > 0)
+        GrowInternTable(numSlots);
+}
+
+void StringPool::GrowInternTable(size_t numSlots)
+{
+    std::vector<InternSlot> slots(numSlots, InternSlot{0, StringRef{0, kEmptySlot}});
+    int shift = 64;
+    for (size_t size = slots.size(); size > 1; size >>= 1)
+        --shift;
+
+    size_t mask = slots.size() - 1;
+    for (const InternSlot &entry : _internSlots)
+    {
+        if (entry.ref.length == kEmptySlot)
+            continue;
+        size_t slot = size_t((entry.hash * 0x9E3779B97F4A7C15ull) >> shift); // as GetInternSlot with the new size
+        while (slots[slot].ref.length != kEmptySlot)
+            slot = (slot + 1) & mask;
+        slots[slot] = entry;
+    }
+
+    _internSlots.swap(slots);
+    _internShift = shift;
+}
+
+void StringPool::ReleaseInternTable()
+{
+    // strings interned afterwards start a new table, so they are no longer shared with the earlier ones
+    std::vector<InternSlot>().swap(_internSlots);
+    _numInterned = 0;
+    _internShift = 64;
+}
+
+void StringPool::Clear()
+{
+    _chars.clear();
+    _internSlots.clear();
+    _numInterned = 0;
+    _internShift = 64;
+}
+
+std::string_view StringList::at(size_t index) const
+{
+    if (index >= _size)
+        throw std::out_of_range("StringList::at");
+    return (*this)[index];
+}
@@ -0,0 +1,99 @@
+#ifndef STRINGPOOL_H_
+#define STRINGPOOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// position of a string in a pool (also the layout used by the binary answer graph file)
+struct StringRef
+{
+    uint32_t offset; // position of the first character
+    uint32_t length; // number of characters
+};
+
+// append-only storage for the characters of many strings; strings added with Intern are stored
+// only once, so equal keywords and answers of different nodes and edges share their characters
+class StringPool
+{
+private:
+    // slot of the interning table (open addressing with linear probing)
+    struct InternSlot
+    {
+        uint64_t hash; // hash of the string, to skip most comparisons and to grow the table without rehashing
+        StringRef ref; // length kEmptySlot marks an empty slot
+    };
+    static constexpr uint32_t kEmptySlot = UINT32_MAX;
+
+    // proprietary members
+    std::string _chars;                   // all strings back to back
+    std::vector<InternSlot> _internSlots; // power of two size, at most half full
+    size_t _numInterned;
+    int _internShift;                     // 64 - log2 of the table size
+
+    // proprietary functions
+    size_t GetInternSlot(uint64_t hash) const { return size_t((hash * 0x9E3779B97F4A7C15ull) >> _internShift); } // Fibonacci hashing
+    StringRef Intern(std::string_view str, uint64_t hash);
+    void GrowInternTable(size_t numSlots);
+
+public:
+    // constructor
+    StringPool() : _numInterned(0), _internShift(64) {}
+
+    // getter / setter
+    const char *GetData() const { return _chars.data(); }
+    size_t GetSize() const { return _chars.size(); }
+    std::string_view Get(StringRef ref) const { return std::string_view(_chars.data() + ref.offset, ref.length); }
+
+    // proprietary functions
+    StringRef Add(std::string_view str);    // always appends
+    StringRef Intern(std::string_view str); // returns the reference of an equal interned string if there is one
+    // interns strings of source and updates their references, optionally returning the hash of each string
+    void Intern(const StringPool &source, StringRef *refs, size_t count, std::vector<uint64_t> *hashes = nullptr);
+    void Reserve(size_t numChars, size_t numInterned = 0); // avoids growing the storage and the interning table
+    void ReleaseInternTable(); // once no more strings are interned, the strings themselves stay
+    void Clear();
+
+    static uint64_t Hash(std::string_view str); // used for interning
+};
+
+// read-only view of consecutive strings in a pool, e.g. all answers of a node
+class StringList
+{
+private:
+    // data handles (not owned)
+    const StringRef *_refs;
+    const char *_chars;
+    size_t _size;
+
+public:
+    class const_iterator
+    {
+    private:
+        const StringRef *_ref;
+        const char *_chars;
+
+    public:
+        const_iterator(const StringRef *ref, const char *chars) : _ref(ref), _chars(chars) {}
+        std::string_view operator*() const { return std::string_view(_chars + _ref->offset, _ref->length); }
+        const_iterator &operator++() { ++_ref; return *this; }
+        bool operator!=(const const_iterator &other) const { return _ref != other._ref; }
+        bool operator==(const const_iterator &other) const { return _ref == other._ref; }
+    };
+
+    // constructor
+    StringList() : _refs(nullptr), _chars(nullptr), _size(0) {}
+    StringList(const StringRef *refs, const char *chars, size_t size) : _refs(refs), _chars(chars), _size(size) {}
+
+    // getter / setter
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    std::string_view operator[](size_t index) const { return std::string_view(_chars + _refs[index].offset, _refs[index].length); }
+    std::string_view at(size_t index) const;
+    const_iterator begin() const { return const_iterator(_refs, _chars); }
+    const_iterator end() const { return const_iterator(_refs + _size, _chars); }
+};
+
+#endif /* STRINGPOOL_H_ */
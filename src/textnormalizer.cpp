@@ -0,0 +1,244 @@
+#include <cstdint>
+#include <cstring>
+
+#include "textnormalizer.h"
+
+// SSE2 is part of every x86-64 processor, NEON of every AArch64 processor
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define MEMBOT_NORMALIZER_X86
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define MEMBOT_NORMALIZER_NEON
+#endif
+
+// AVX2 kernels are compiled with a function attribute, so the rest of the program needs no special flags
+#if defined(MEMBOT_NORMALIZER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define MEMBOT_NORMALIZER_AVX2
+#endif
+
+namespace
+{
+// kernels write the normalized form of [text, text + size) to out and return the end of the output
+typedef char *(*NormalizerKernel)(const char *text, size_t size, char *out);
+
+// x must not be zero
+inline size_t CountTrailingZeros(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    size_t n = 0;
+    for (; (x & 1) == 0; x >>= 1)
+        ++n;
+    return n;
+#endif
+}
+
+bool IsWordByte(unsigned char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c >= 0x80;
+}
+
+// state between chunks: the output written so far and whether a separator is pending
+struct NormalizerOutput
+{
+    char *begin;
+    char *end;
+    bool separator;
+
+    void Append(char c)
+    {
+        // a blank is only written between two words
+        if (separator && end != begin)
+            *end++ = ' ';
+        separator = false;
+        *end++ = c;
+    }
+
+    // appends a chunk of upper-case bytes, bit i of wordMask is set if byte i belongs to a word
+    void AppendChunk(const char *folded, uint32_t wordMask, size_t size)
+    {
+        // copy one run of word bytes at a time, bits above size are zero
+        uint64_t mask = wordMask;
+        size_t i = 0;
+        while (i < size)
+        {
+            uint64_t rest = mask >> i;
+            if (rest == 0)
+            {
+                separator = true;
+                break;
+            }
+
+            size_t skip = CountTrailingZeros(rest);
+            if (skip > 0)
+                separator = true;
+            i += skip;
+
+            size_t run = CountTrailingZeros(~(mask >> i));
+            if (separator && end != begin)
+                *end++ = ' ';
+            separator = false;
+            std::memcpy(end, folded + i, run);
+            end += run;
+            i += run;
+        }
+    }
+};
+
+void NormalizeScalarBytes(const char *text, size_t size, NormalizerOutput &out)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        unsigned char c = text[i];
+        if (IsWordByte(c))
+            out.Append((c >= 'a' && c <= 'z') ? char(c - ('a' - 'A')) : char(c));
+        else
+            out.separator = true;
+    }
+}
+
+char *NormalizeScalar(const char *text, size_t size, char *out)
+{
+    NormalizerOutput output{out, out, false};
+    NormalizeScalarBytes(text, size, output);
+    return output.end;
+}
+
+#if defined(MEMBOT_NORMALIZER_X86)
+char *NormalizeSse2(const char *text, size_t size, char *out)
+{
+    NormalizerOutput output{out, out, false};
+    alignas(16) char folded[16];
+
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        // signed comparisons, bytes outside of ASCII are negative
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+        __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('z' + 1)));
+        __m128i upper = _mm_sub_epi8(v, _mm_and_si128(lower, _mm_set1_epi8(0x20)));
+        __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(upper, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(upper, _mm_set1_epi8('Z' + 1)));
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+        __m128i high = _mm_cmplt_epi8(v, _mm_setzero_si128());
+        __m128i word = _mm_or_si128(_mm_or_si128(letter, digit), high);
+
+        _mm_store_si128(reinterpret_cast<__m128i *>(folded), upper);
+        output.AppendChunk(folded, uint32_t(_mm_movemask_epi8(word)), 16);
+    }
+
+    NormalizeScalarBytes(text + i, size - i, output);
+    return output.end;
+}
+#endif
+
+#if defined(MEMBOT_NORMALIZER_AVX2)
+__attribute__((target("avx2"))) char *NormalizeAvx2(const char *text, size_t size, char *out)
+{
+    NormalizerOutput output{out, out, false};
+    alignas(32) char folded[32];
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        // signed comparisons, bytes outside of ASCII are negative
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i));
+        __m256i lower = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), v));
+        __m256i upper = _mm256_sub_epi8(v, _mm256_and_si256(lower, _mm256_set1_epi8(0x20)));
+        __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(upper, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), upper));
+        __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+        __m256i high = _mm256_cmpgt_epi8(_mm256_setzero_si256(), v);
+        __m256i word = _mm256_or_si256(_mm256_or_si256(letter, digit), high);
+
+        _mm256_store_si256(reinterpret_cast<__m256i *>(folded), upper);
+        output.AppendChunk(folded, uint32_t(_mm256_movemask_epi8(word)), 32);
+    }
+
+    NormalizeScalarBytes(text + i, size - i, output);
+    return output.end;
+}
+#endif
+
+#if defined(MEMBOT_NORMALIZER_NEON)
+char *NormalizeNeon(const char *text, size_t size, char *out)
+{
+    NormalizerOutput output{out, out, false};
+    alignas(16) char folded[16];
+    static const uint8_t kBits[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t bits = vld1q_u8(kBits);
+
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        // unsigned comparisons, bytes outside of ASCII are 0x80 and above
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(text + i));
+        uint8x16_t lower = vandq_u8(vcgeq_u8(v, vdupq_n_u8('a')), vcleq_u8(v, vdupq_n_u8('z')));
+        uint8x16_t upper = vsubq_u8(v, vandq_u8(lower, vdupq_n_u8(0x20)));
+        uint8x16_t letter = vandq_u8(vcgeq_u8(upper, vdupq_n_u8('A')), vcleq_u8(upper, vdupq_n_u8('Z')));
+        uint8x16_t digit = vandq_u8(vcgeq_u8(v, vdupq_n_u8('0')), vcleq_u8(v, vdupq_n_u8('9')));
+        uint8x16_t high = vcgeq_u8(v, vdupq_n_u8(0x80));
+        uint8x16_t word = vandq_u8(vorrq_u8(vorrq_u8(letter, digit), high), bits);
+
+        // one bit per byte, as _mm_movemask_epi8 does
+        uint32_t mask = vaddv_u8(vget_low_u8(word)) | (uint32_t(vaddv_u8(vget_high_u8(word))) << 8);
+        vst1q_u8(reinterpret_cast<uint8_t *>(folded), upper);
+        output.AppendChunk(folded, mask, 16);
+    }
+
+    NormalizeScalarBytes(text + i, size - i, output);
+    return output.end;
+}
+#endif
+
+struct SelectedKernel
+{
+    NormalizerKernel kernel;
+    const char *name;
+};
+
+SelectedKernel SelectKernel()
+{
+#if defined(MEMBOT_NORMALIZER_AVX2)
+    if (__builtin_cpu_supports("avx2"))
+        return SelectedKernel{NormalizeAvx2, "avx2"};
+#endif
+#if defined(MEMBOT_NORMALIZER_X86)
+    return SelectedKernel{NormalizeSse2, "sse2"};
+#elif defined(MEMBOT_NORMALIZER_NEON)
+    return SelectedKernel{NormalizeNeon, "neon"};
+#else
+    return SelectedKernel{NormalizeScalar, "scalar"};
+#endif
+}
+
+const SelectedKernel &GetSelectedKernel()
+{
+    // the CPU is only inspected once
+    static const SelectedKernel selected = SelectKernel();
+    return selected;
+}
+
+void Normalize(NormalizerKernel kernel, std::string_view text, std::string &normalized)
+{
+    // the normalized form is never longer than the text
+    normalized.resize(text.size());
+    char *out = normalized.empty() ? nullptr : &normalized[0];
+    normalized.resize(text.empty() ? 0 : kernel(text.data(), text.size(), out) - out);
+}
+} // namespace
+
+void NormalizeText(std::string_view text, std::string &normalized)
+{
+    Normalize(GetSelectedKernel().kernel, text, normalized);
+}
+
+void NormalizeTextScalar(std::string_view text, std::string &normalized)
+{
+    Normalize(NormalizeScalar, text, normalized);
+}
+
+const char *GetTextNormalizerKernel()
+{
+    return GetSelectedKernel().name;
+}
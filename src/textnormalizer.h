@@ -0,0 +1,22 @@
+#ifndef TEXTNORMALIZER_H_
+#define TEXTNORMALIZER_H_
+
+#include <string>
+#include <string_view>
+
+// Normalization applied once to every user message and keyword before they are compared:
+// ASCII letters are folded to upper-case, each run of other ASCII characters (blanks, punctuation,
+// control characters) becomes a single blank and leading / trailing blanks are dropped.
+// Bytes outside of ASCII (e.g. UTF-8 sequences) are kept as they are.
+// The result consists of words separated by one blank, e.g. "  What's a  smart-pointer?" -> "WHAT S A SMART POINTER".
+// Classification and folding run 16 or 32 bytes at a time with SSE2 / AVX2 (selected at runtime)
+// or NEON where available, with a scalar fallback that produces identical output.
+void NormalizeText(std::string_view text, std::string &normalized); // replaces the contents of normalized
+
+// scalar implementation, for comparison
+void NormalizeTextScalar(std::string_view text, std::string &normalized);
+
+// name of the implementation used by NormalizeText ("avx2", "sse2", "neon" or "scalar")
+const char *GetTextNormalizerKernel();
+
+#endif /* TEXTNORMALIZER_H_ */
@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <utility>
+
+#include "levenshtein.h"
+#include "tokenindex.h"
+
+namespace
+{
+// stores the [begin, end) position of each word of a normalized text (words are separated by one blank)
+void FindWords(std::string_view normalized, std::vector<uint32_t> &bounds)
+{
+    if (normalized.empty())
+        return;
+
+    bounds.push_back(0);
+    for (size_t i = 0; i < normalized.size(); ++i)
+    {
+        if (normalized[i] == ' ')
+        {
+            bounds.push_back(i);
+            bounds.push_back(i + 1);
+        }
+    }
+    bounds.push_back(normalized.size());
+}
+
+// calls f with each trigram of the word padded by one blank on either side
+template <typename Function>
+void ForEachTrigram(std::string_view word, Function f)
+{
+    auto at = [word](size_t i) -> uint32_t { return (i == 0 || i > word.size()) ? ' ' : static_cast<unsigned char>(word[i - 1]); };
+    for (size_t i = 0; i < word.size(); ++i)
+        f((at(i) << 16) | (at(i + 1) << 8) | at(i + 2));
+}
+
+// scratch memory of FindBestEntry, reused by all calls on the same thread
+struct MatchScratch
+{
+    std::vector<uint32_t> bounds;
+    std::vector<uint32_t> hits;                   // shared trigrams per keyword of the current message word
+    std::vector<uint32_t> touched;                // keywords with hits for the current message word
+    std::vector<std::pair<uint32_t, uint32_t>> wordHits; // <keyword,message word> for every hit, see hitCounts
+    std::vector<uint32_t> hitCounts;              // shared trigrams per entry of wordHits
+    std::vector<uint32_t> order;                  // positions in wordHits, ordered by keyword
+    std::vector<uint32_t> windowHits;             // shared trigrams per message word for one keyword
+};
+} // namespace
+
+KeywordTokenIndex::KeywordTokenIndex()
+{
+    _buffer = nullptr;
+    _slotShift = 32;
+}
+
+int KeywordTokenIndex::FindTrigram(uint32_t trigram) const
+{
+    if (_slots.empty())
+        return -1;
+
+    // Fibonacci hashing with linear probing, the table is at most half full
+    uint32_t mask = _slots.size() - 1;
+    for (uint32_t slot = (trigram * 2654435769u) >> _slotShift;; slot = (slot + 1) & mask)
+    {
+        if (_slots[slot] == 0)
+            return -1;
+        if (_trigrams[_slots[slot] - 1] == trigram)
+            return _slots[slot] - 1;
+    }
+}
+
+void KeywordTokenIndex::Build(const char *buffer, const KeywordMatcher::Entry *entries, size_t numEntries)
+{
+    _buffer = buffer;
+    _keywords.clear();
+    _keywords.reserve(numEntries);
+
+    // collect <trigram,entry> pairs, entries are visited in ascending order
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    std::vector<uint32_t> bounds;
+    for (size_t i = 0; i < numEntries; ++i)
+    {
+        bounds.clear();
+        FindWords(std::string_view(buffer + entries[i].offset, entries[i].length), bounds);
+
+        Keyword keyword;
+        keyword.offset = entries[i].offset;
+        keyword.length = entries[i].length;
+        keyword.numWords = bounds.size() / 2;
+        // about one typo per four characters, so short keywords must match exactly
+        keyword.maxDist = keyword.length / 4;
+        _keywords.push_back(keyword);
+
+        for (size_t w = 0; w < bounds.size(); w += 2)
+        {
+            std::string_view word(buffer + keyword.offset + bounds[w], bounds[w + 1] - bounds[w]);
+            ForEachTrigram(word, [&pairs, i](uint32_t trigram) { pairs.emplace_back(trigram, uint32_t(i)); });
+        }
+    }
+
+    // sort by trigram (stable, so the postings of each trigram stay ascending) and drop duplicates
+    std::stable_sort(pairs.begin(), pairs.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    _trigrams.clear();
+    _postingOffsets.clear();
+    _postings.clear();
+    _postings.reserve(pairs.size());
+    for (const auto &pair : pairs)
+    {
+        if (_trigrams.empty() || _trigrams.back() != pair.first)
+        {
+            _trigrams.push_back(pair.first);
+            _postingOffsets.push_back(_postings.size());
+        }
+        _postings.push_back(pair.second);
+    }
+    _postingOffsets.push_back(_postings.size());
+
+    // messages look up every one of their trigrams, so the sorted trigrams get a hash table on top
+    _slotShift = 31;
+    while ((size_t(1) << (32 - _slotShift)) < 2 * _trigrams.size())
+        --_slotShift;
+    _slots.assign(size_t(1) << (32 - _slotShift), 0);
+    uint32_t mask = _slots.size() - 1;
+    for (uint32_t i = 0; i < _trigrams.size(); ++i)
+    {
+        uint32_t slot = (_trigrams[i] * 2654435769u) >> _slotShift;
+        while (_slots[slot] != 0)
+            slot = (slot + 1) & mask;
+        _slots[slot] = i + 1;
+    }
+}
+
+int KeywordTokenIndex::FindBestEntry(std::string_view message, uint32_t firstEntry, uint32_t numEntries, LevenshteinEngine &engine, int *distance) const
+{
+    thread_local MatchScratch scratch;
+    scratch.bounds.clear();
+    FindWords(message, scratch.bounds);
+    size_t numWords = scratch.bounds.size() / 2;
+    if (numWords == 0 || numEntries == 0)
+        return -1;
+
+    // count the trigrams every message word shares with the keywords of the node
+    scratch.hits.assign(numEntries, 0);
+    scratch.wordHits.clear();
+    scratch.hitCounts.clear();
+    for (size_t w = 0; w < numWords; ++w)
+    {
+        std::string_view word(message.data() + scratch.bounds[2 * w], scratch.bounds[2 * w + 1] - scratch.bounds[2 * w]);
+        ForEachTrigram(word, [&](uint32_t trigram) {
+            int index = FindTrigram(trigram);
+            if (index < 0)
+                return;
+
+            // postings are ascending, so the entries of the node are a contiguous range
+            const uint32_t *begin = _postings.data() + _postingOffsets[index];
+            const uint32_t *end = _postings.data() + _postingOffsets[index + 1];
+            for (const uint32_t *p = std::lower_bound(begin, end, firstEntry); p != end && *p < firstEntry + numEntries; ++p)
+            {
+                if (scratch.hits[*p - firstEntry]++ == 0)
+                    scratch.touched.push_back(*p - firstEntry);
+            }
+        });
+
+        for (uint32_t entry : scratch.touched)
+        {
+            scratch.wordHits.emplace_back(entry, uint32_t(w));
+            scratch.hitCounts.push_back(scratch.hits[entry]);
+            scratch.hits[entry] = 0;
+        }
+        scratch.touched.clear();
+    }
+
+    // visit the shortlisted keywords in entry order with a counting sort (words stay ascending within a keyword)
+    std::vector<uint32_t> &offsets = scratch.hits;
+    for (const auto &hit : scratch.wordHits)
+        offsets[hit.first]++;
+    for (uint32_t i = 0, sum = 0; i < numEntries; ++i)
+    {
+        uint32_t count = offsets[i];
+        offsets[i] = sum;
+        sum += count;
+    }
+    std::vector<uint32_t> &order = scratch.order;
+    order.resize(scratch.wordHits.size());
+    for (size_t i = 0; i < scratch.wordHits.size(); ++i)
+        order[offsets[scratch.wordHits[i].first]++] = i;
+
+    int bestEntry = -1;
+    int bestDist = 0;
+    uint32_t bestLength = 0;
+    scratch.windowHits.assign(numWords, 0);
+    for (size_t first = 0; first < order.size();)
+    {
+        uint32_t entry = scratch.wordHits[order[first]].first;
+        size_t last = first;
+        for (; last < order.size() && scratch.wordHits[order[last]].first == entry; ++last)
+            scratch.windowHits[scratch.wordHits[order[last]].second] = scratch.hitCounts[order[last]];
+
+        const Keyword &keyword = _keywords[firstEntry + entry];
+
+        // only a smaller distance, or the same distance with a longer keyword, can replace the current best entry
+        int maxDist = keyword.maxDist;
+        if (bestEntry >= 0)
+            maxDist = std::min(maxDist, keyword.length > bestLength ? bestDist : bestDist - 1);
+
+        // a run of words within distance d of the keyword keeps all but at most 3 * d of its trigrams,
+        // so only those runs of consecutive message words are compared that share enough trigrams
+        uint32_t numTrigrams = keyword.length - (keyword.numWords - 1);
+        std::string_view text(_buffer + keyword.offset, keyword.length);
+        uint32_t sum = 0;
+        for (size_t w = 0; maxDist >= 0 && keyword.numWords <= numWords && w < numWords; ++w)
+        {
+            sum += scratch.windowHits[w];
+            if (w >= keyword.numWords)
+                sum -= scratch.windowHits[w - keyword.numWords];
+            if (w + 1 < keyword.numWords || sum + 3 * uint32_t(maxDist) < numTrigrams)
+                continue;
+
+            uint32_t begin = scratch.bounds[2 * (w + 1 - keyword.numWords)];
+            uint32_t end = scratch.bounds[2 * w + 1];
+            int dist = engine.ComputeDistanceWithin(text, std::string_view(message.data() + begin, end - begin), maxDist);
+            if (dist <= maxDist)
+            {
+                bestEntry = firstEntry + entry;
+                bestDist = dist;
+                bestLength = keyword.length;
+                maxDist = dist - 1;
+            }
+        }
+
+        for (size_t i = first; i < last; ++i)
+            scratch.windowHits[scratch.wordHits[order[i]].second] = 0;
+        first = last;
+    }
+
+    if (distance != nullptr)
+        *distance = bestDist;
+
+    return bestEntry;
+}
@@ -0,0 +1,62 @@
+#ifndef TOKENINDEX_H_
+#define TOKENINDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "keywordmatcher.h"
+
+class LevenshteinEngine; // forward declaration
+
+// Inverted index from word trigrams to the keywords of an answer graph, for matching keywords
+// against the words of a longer message instead of against the whole message.
+// Keywords and messages are normalized (see NormalizeText), so they consist of words separated by
+// one blank, and every word contributes the trigrams of its padded form, e.g. " HEAP " -> " HE", "HEA", "EAP", "AP ".
+// Only keywords sharing enough trigrams with the message are verified by Levenshtein distance,
+// each against every run of consecutive message words with the same number of words.
+class KeywordTokenIndex
+{
+public:
+    // proprietary type definitions
+    struct Keyword
+    {
+        uint32_t offset;   // position of the normalized keyword in the matching buffer
+        uint32_t length;   // number of characters
+        uint32_t numWords; // number of words, zero if the keyword has no word characters
+        uint32_t maxDist;  // largest distance that still counts as a match
+    };
+
+private:
+    // proprietary members
+    const char *_buffer;                   // normalized keywords of the graph (not owned)
+    std::vector<Keyword> _keywords;        // one per keyword matching entry of the graph
+    std::vector<uint32_t> _trigrams;       // sorted and unique
+    std::vector<uint32_t> _postingOffsets; // first posting of each trigram (CSR, _trigrams.size() + 1)
+    std::vector<uint32_t> _postings;       // keyword matching entries per trigram, ascending
+    std::vector<uint32_t> _slots;          // open addressing hash table of positions in _trigrams (+1, zero if empty)
+    uint32_t _slotShift;                   // 32 - log2 of the number of slots
+
+    // proprietary functions
+    int FindTrigram(uint32_t trigram) const; // position in _trigrams or -1
+
+public:
+    // constructor
+    KeywordTokenIndex();
+
+    // getter / setter
+    bool IsEmpty() const { return _keywords.empty(); }
+    size_t GetNumberOfTrigrams() const { return _trigrams.size(); }
+
+    // proprietary functions
+    // builds the index over all keyword matching entries (normalized keywords in buffer, which must outlive the index)
+    void Build(const char *buffer, const KeywordMatcher::Entry *entries, size_t numEntries);
+
+    // returns the matching entry in [firstEntry, firstEntry + numEntries) whose keyword is closest
+    // to some words of the normalized message, or -1 if no keyword is within its distance limit
+    // (smaller distance wins, then the longer keyword, then the first entry)
+    int FindBestEntry(std::string_view message, uint32_t firstEntry, uint32_t numEntries, LevenshteinEngine &engine, int *distance = nullptr) const;
+};
+
+#endif /* TOKENINDEX_H_ */
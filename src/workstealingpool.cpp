@@ -0,0 +1,121 @@
+#include <algorithm>
+
+#include "workstealingpool.h"
+
+WorkStealingPool::WorkStealingPool(size_t numWorkers)
+    : _job(nullptr), _remaining(0), _batch(0), _isStopping(false)
+{
+    if (numWorkers == 0)
+        numWorkers = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 0; i < numWorkers; ++i)
+        _queues.push_back(std::make_unique<WorkerQueue>());
+
+    // worker 0 is the thread calling Run
+    for (size_t i = 1; i < numWorkers; ++i)
+        _threads.emplace_back(&WorkStealingPool::Work, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _isStopping = true;
+    }
+    _wakeCondition.notify_all();
+    for (std::thread &thread : _threads)
+        thread.join();
+}
+
+void WorkStealingPool::Run(size_t numTasks, const std::function<void(size_t task, size_t worker)> &job)
+{
+    if (numTasks == 0)
+        return;
+
+    // hand out contiguous ranges, before any worker can see the new batch
+    _job = &job;
+    _remaining.store(numTasks, std::memory_order_relaxed);
+    size_t numWorkers = _queues.size();
+    for (size_t i = 0; i < numWorkers; ++i)
+    {
+        std::lock_guard<std::mutex> lock(_queues[i]->mutex);
+        for (size_t task = numTasks * i / numWorkers; task < numTasks * (i + 1) / numWorkers; ++task)
+            _queues[i]->tasks.push_back(task);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_batch;
+    }
+    _wakeCondition.notify_all();
+
+    RunTasks(0);
+
+    // tasks stolen by other workers may still be running
+    std::unique_lock<std::mutex> lock(_mutex);
+    _doneCondition.wait(lock, [this] { return _remaining.load(std::memory_order_acquire) == 0; });
+    _job = nullptr;
+}
+
+bool WorkStealingPool::PopTask(size_t worker, size_t &task)
+{
+    // own tasks are taken in order
+    {
+        WorkerQueue &queue = *_queues[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+
+    // steal from the end of the other queues, starting with the next worker
+    for (size_t i = 1; i < _queues.size(); ++i)
+    {
+        WorkerQueue &queue = *_queues[(worker + i) % _queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingPool::RunTasks(size_t worker)
+{
+    size_t task;
+    while (PopTask(worker, task))
+    {
+        (*_job)(task, worker);
+
+        // the last task wakes up the thread waiting in Run
+        if (_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _doneCondition.notify_one();
+        }
+    }
+}
+
+void WorkStealingPool::Work(size_t worker)
+{
+    uint64_t batch = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wakeCondition.wait(lock, [this, batch] { return _isStopping || _batch != batch; });
+            if (_isStopping)
+                return;
+            batch = _batch;
+        }
+
+        RunTasks(worker);
+    }
+}
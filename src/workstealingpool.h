@@ -0,0 +1,65 @@
+#ifndef WORKSTEALINGPOOL_H_
+#define WORKSTEALINGPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that run batches of independent tasks. Each worker starts with a
+// contiguous range of the task indices in its own queue and takes them in order, so neighbouring
+// tasks (e.g. those working on the same data) run on the same core. A worker whose queue is empty
+// steals from the far end of the other queues, which keeps all cores busy when tasks differ in size.
+// The thread calling Run takes part as worker 0.
+class WorkStealingPool
+{
+private:
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    // proprietary members
+    std::vector<std::unique_ptr<WorkerQueue>> _queues; // one per worker, including the calling thread
+    std::vector<std::thread> _threads;
+    const std::function<void(size_t, size_t)> *_job;   // job of the current batch
+    std::atomic<size_t> _remaining;                     // tasks of the current batch not finished yet
+
+    // workers sleep between batches
+    std::mutex _mutex;
+    std::condition_variable _wakeCondition;
+    std::condition_variable _doneCondition;
+    uint64_t _batch;
+    bool _isStopping;
+
+    // proprietary functions
+    bool PopTask(size_t worker, size_t &task);
+    void RunTasks(size_t worker);
+    void Work(size_t worker);
+
+public:
+    // constructor / destructor
+    explicit WorkStealingPool(size_t numWorkers = 0); // 0 uses one worker per hardware thread
+    ~WorkStealingPool();
+
+    // the worker threads refer to this instance
+    WorkStealingPool(const WorkStealingPool &source) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &source) = delete;
+
+    // getter / setter
+    size_t GetNumberOfWorkers() const { return _queues.size(); }
+
+    // proprietary functions
+    // calls job(task, worker) for every task in [0, numTasks) and returns once all calls are done,
+    // worker is in [0, GetNumberOfWorkers()) and identifies per-worker scratch memory
+    void Run(size_t numTasks, const std::function<void(size_t task, size_t worker)> &job);
+};
+
+#endif /* WORKSTEALINGPOOL_H_ */
@@ -0,0 +1,74 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <set>
+#include <thread>
+
+#include "chatlogic.h"
+#include "chatworker.h"
+
+// queues requests while the worker is held after the first one, the last of them superseding the others:
+// only the first (already answered) and the last request may be answered, the skipped ones never reach the chatbot
+int main(int argc, char *argv[])
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: membot_chatworkertest <answergraph.txt>" << std::endl;
+        return 2;
+    }
+
+    ChatLogic chatLogic;
+    if (!chatLogic.LoadAnswerGraphFromFile(argv[1]))
+        return 1;
+
+    // the worker waits in the notification of its first request until all requests are queued
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<int> numNotified(0);
+    ChatWorker worker(&chatLogic, [&numNotified, released]() {
+        if (numNotified.fetch_add(1) == 0)
+            released.wait();
+    });
+
+    ChatWorker::RequestID first = worker.Submit("pointers");
+    while (numNotified.load() == 0)
+        std::this_thread::yield();
+    ChatWorker::RequestID skipped1 = worker.Submit("smart");
+    ChatWorker::RequestID skipped2 = worker.Submit("unique");
+    ChatWorker::RequestID last = worker.Submit("heap", true);
+    release.set_value();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (worker.IsBusy() && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::yield();
+
+    std::multiset<ChatWorker::RequestID> answered;
+    ChatWorker::Response response;
+    while (worker.PopResponse(response))
+        answered.insert(response.request);
+
+    int numErrors = 0;
+    if (worker.IsBusy())
+    {
+        std::cerr << "The worker has not finished its requests" << std::endl;
+        numErrors++;
+    }
+    for (ChatWorker::RequestID id : {first, last})
+    {
+        if (answered.count(id) != 1)
+        {
+            std::cerr << "Request " << id << " has " << answered.count(id) << " answers instead of one" << std::endl;
+            numErrors++;
+        }
+    }
+    for (ChatWorker::RequestID id : {skipped1, skipped2})
+    {
+        if (answered.count(id) != 0)
+        {
+            std::cerr << "Superseded request " << id << " has been answered" << std::endl;
+            numErrors++;
+        }
+    }
+    return numErrors;
+}
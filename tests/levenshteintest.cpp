@@ -0,0 +1,68 @@
+#include <iostream>
+#include <string>
+
+#include "levenshtein.h"
+#include "rng.h"
+
+namespace
+{
+// mixed-case letters from a small alphabet, so that matches and case folding are frequent
+std::string RandomString(Pcg32 &rng, size_t length)
+{
+    static const char kAlphabet[] = "abcdABCDxy";
+    std::string str(length, ' ');
+    for (char &c : str)
+        c = kAlphabet[rng.NextBelow(sizeof(kAlphabet) - 1)];
+    return str;
+}
+
+// a few random insertions, deletions and substitutions, so that distances are small as well
+std::string Mutate(Pcg32 &rng, std::string str)
+{
+    for (uint32_t n = rng.NextBelow(6); n > 0; --n)
+    {
+        size_t pos = str.empty() ? 0 : rng.NextBelow(str.size());
+        switch (rng.NextBelow(3))
+        {
+        case 0:
+            str.insert(pos, 1, 'z');
+            break;
+        case 1:
+            if (!str.empty())
+                str.erase(pos, 1);
+            break;
+        default:
+            if (!str.empty())
+                str[pos] = 'z';
+        }
+    }
+    return str;
+}
+} // namespace
+
+// compares the bit-parallel distances with the reference implementation on random strings of up to
+// 64 characters (single word) and of more than 64 characters (blocked), returns the number of mismatches
+int main()
+{
+    Pcg32 rng(42);
+    LevenshteinEngine engine;
+    int numErrors = 0;
+    for (int i = 0; i < 20000 && numErrors < 10; ++i)
+    {
+        size_t maxLength = i % 2 == 0 ? 64 : 300;
+        std::string s1 = RandomString(rng, rng.NextBelow(maxLength + 1));
+        std::string s2 = rng.NextBelow(2) == 0 ? Mutate(rng, s1) : RandomString(rng, rng.NextBelow(maxLength + 1));
+
+        int expected = LevenshteinEngine::ComputeDistanceReference(s1, s2);
+        int distance = engine.ComputeDistance(s1, s2);
+        int maxDist = int(rng.NextBelow(uint32_t(expected) + 4));
+        int bounded = engine.ComputeDistanceWithin(s1, s2, maxDist);
+        if (distance != expected || (expected <= maxDist ? bounded != expected : bounded <= maxDist))
+        {
+            std::cerr << "Mismatch for \"" << s1 << "\" and \"" << s2 << "\": reference " << expected << ", ComputeDistance " << distance
+                      << ", ComputeDistanceWithin(" << maxDist << ") " << bounded << std::endl;
+            numErrors++;
+        }
+    }
+    return numErrors;
+}
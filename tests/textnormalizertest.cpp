@@ -0,0 +1,70 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "rng.h"
+#include "textnormalizer.h"
+
+namespace
+{
+// mostly letters, digits and separators, so that words and runs of blanks of all lengths straddle the
+// vector boundaries, plus control characters and bytes outside of ASCII
+char RandomByte(Pcg32 &rng)
+{
+    static const char kCommon[] = "abcXYZ09  .,-'?";
+    switch (rng.NextBelow(4))
+    {
+    case 0:
+        return char(rng.NextBelow(256));
+    case 1:
+        return char(0x80 + rng.NextBelow(128));
+    default:
+        return kCommon[rng.NextBelow(sizeof(kCommon) - 1)];
+    }
+}
+
+std::string Printable(std::string_view str)
+{
+    static const char kHex[] = "0123456789abcdef";
+    std::string printable;
+    for (unsigned char c : str)
+    {
+        if (c >= 0x20 && c < 0x7f)
+            printable.push_back(char(c));
+        else
+            printable += std::string("\\x") + kHex[c >> 4] + kHex[c & 15];
+    }
+    return printable;
+}
+} // namespace
+
+// compares the vectorized NormalizeText with the scalar implementation on random input of every length up to
+// 70 bytes (one to two vectors plus a tail) at every offset within a 32-byte vector, returns the number of mismatches
+int main()
+{
+    Pcg32 rng(7);
+    std::string buffer, expected, normalized;
+    int numErrors = 0;
+    for (int round = 0; round < 50 && numErrors < 10; ++round)
+    {
+        for (size_t offset = 0; offset < 32; ++offset)
+        {
+            for (size_t length = 0; length <= 70; ++length)
+            {
+                buffer.resize(offset + length);
+                for (char &c : buffer)
+                    c = RandomByte(rng);
+                std::string_view text = std::string_view(buffer).substr(offset);
+
+                NormalizeTextScalar(text, expected);
+                NormalizeText(text, normalized);
+                if (normalized != expected && numErrors++ < 10)
+                {
+                    std::cerr << "Mismatch (" << GetTextNormalizerKernel() << ") for \"" << Printable(text) << "\": scalar \""
+                              << Printable(expected) << "\", vectorized \"" << Printable(normalized) << "\"" << std::endl;
+                }
+            }
+        }
+    }
+    return numErrors;
+}
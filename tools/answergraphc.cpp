@@ -0,0 +1,65 @@
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "graphparser.h"
+#include "graphfile.h"
+
+namespace
+{
+// writes the binary image as a C++ header, so that it can be compiled into an executable
+bool WriteHeader(const std::string &filename, const std::string &source, const std::string &image)
+{
+    std::ofstream file(filename, std::ios::trunc);
+    if (!file)
+    {
+        std::cout << "Error: " << filename << " could not be written" << std::endl;
+        return false;
+    }
+
+    file << "// generated by answergraphc from " << source << ", do not edit\n"
+         << "#ifndef EMBEDDEDANSWERGRAPHDATA_H_\n"
+         << "#define EMBEDDEDANSWERGRAPHDATA_H_\n\n"
+         << "#include <cstddef>\n\n"
+         << "// binary answer graph image (see graphfile.h), aligned like its tables\n"
+         << "alignas(8) constexpr unsigned char kEmbeddedAnswerGraph[] = {";
+    file << std::hex << std::setfill('0');
+    for (size_t i = 0; i < image.size(); ++i)
+        file << (i % 16 == 0 ? "\n    " : " ") << "0x" << std::setw(2) << unsigned(static_cast<unsigned char>(image[i])) << ",";
+    file << std::dec << "\n};\n"
+         << "constexpr size_t kEmbeddedAnswerGraphSize = " << image.size() << ";\n\n"
+         << "#endif /* EMBEDDEDANSWERGRAPHDATA_H_ */\n";
+    return bool(file);
+}
+} // namespace
+
+// compiles an answer graph from the text format into the binary format, or with --header into a C++ header
+// holding the same binary image
+int main(int argc, char *argv[])
+{
+    bool header = argc == 4 && std::string(argv[1]) == "--header";
+    if (argc != 3 && !header)
+    {
+        std::cout << "Usage: answergraphc [--header] <answergraph.txt> <answergraph.bin | answergraph.h>" << std::endl;
+        return 2;
+    }
+    std::string input = argv[argc - 2];
+    std::string output = argv[argc - 1];
+
+    GraphRecords records;
+    if (!ParseAnswerGraphFile(input, records))
+        return 1;
+
+    if (header)
+    {
+        std::string image;
+        if (!CreateAnswerGraphImage(records, image) || !WriteHeader(output, input, image))
+            return 1;
+    }
+    else if (!WriteAnswerGraphFile(output, records))
+        return 1;
+
+    std::cout << "Wrote " << records.nodes.size() << " nodes and " << records.edges.size() << " edges to " << output << std::endl;
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "answergraph.h"
+#include "graphanalysis.h"
+#include "graphloader.h"
+
+namespace
+{
+const size_t kMaxPrinted = 20; // entries listed per problem
+
+// prints a count and the first few IDs
+void PrintIDs(const char *title, const std::vector<int> &ids)
+{
+    std::cout << title << ": " << ids.size();
+    for (size_t i = 0; i < ids.size() && i < kMaxPrinted; ++i)
+        std::cout << (i ? ", " : " (") << ids[i];
+    if (!ids.empty())
+        std::cout << (ids.size() > kMaxPrinted ? ", ...)" : ")");
+    std::cout << std::endl;
+}
+} // namespace
+
+// reports structural problems of an answer graph, the exit status is 3 if nodes or edges can never be reached
+int main(int argc, char *argv[])
+{
+    if (argc != 2)
+    {
+        std::cout << "Usage: membot_graphcheck <answergraph.txt | answergraph.bin>" << std::endl;
+        return 2;
+    }
+
+    std::unique_ptr<AnswerGraph> graph = LoadAnswerGraph(argv[1]);
+    if (graph == nullptr)
+        return 1;
+
+    AnswerGraphReport report = AnalyzeAnswerGraph(*graph);
+    std::cout << graph->GetNumberOfNodes() << " nodes, " << graph->GetNumberOfEdges() << " edges, " << report.numKeywords << " keywords (counted once per node)" << std::endl;
+    PrintIDs("Unreachable nodes", report.unreachableNodes);
+    PrintIDs("Dead-end nodes (return to the root node)", report.deadEndNodes);
+    PrintIDs("Unmatchable edges", report.unmatchableEdges);
+    std::cout << "Shadowed keywords: " << report.shadowedKeywords.size() << std::endl;
+    for (size_t i = 0; i < report.shadowedKeywords.size() && i < kMaxPrinted; ++i)
+        std::cout << "  edge " << report.shadowedKeywords[i].first << ": \"" << report.shadowedKeywords[i].second << "\"" << std::endl;
+
+    return report.unreachableNodes.empty() && report.unmatchableEdges.empty() ? 0 : 3;
+}
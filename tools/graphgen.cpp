@@ -0,0 +1,41 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "syntheticgraph.h"
+
+// writes a synthetic answer graph for benchmarks and load tests
+int main(int argc, char *argv[])
+{
+    if (argc < 3 || argc > 7)
+    {
+        std::cout << "Usage: membot_graphgen <nodes> <answergraph.txt> [fanout] [keywords per edge] [seed] [vocabulary size]" << std::endl;
+        return 2;
+    }
+
+    SyntheticGraphOptions options;
+    options.numNodes = std::strtoull(argv[1], nullptr, 10);
+    if (argc > 3)
+        options.fanout = std::strtoull(argv[3], nullptr, 10);
+    if (argc > 4)
+        options.keywordsPerEdge = std::strtoull(argv[4], nullptr, 10);
+    if (argc > 5)
+        options.seed = std::strtoull(argv[5], nullptr, 10);
+    if (argc > 6)
+        options.vocabularySize = std::strtoull(argv[6], nullptr, 10);
+    if (options.numNodes == 0 || options.fanout == 0)
+    {
+        std::cout << "Error: number of nodes and fanout must be positive" << std::endl;
+        return 2;
+    }
+
+    size_t bytes = WriteSyntheticAnswerGraph(argv[2], options);
+    if (bytes == 0)
+    {
+        std::cout << "Error: " << argv[2] << " could not be written" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << options.numNodes << " nodes (" << bytes << " bytes) to " << argv[2] << std::endl;
+    return 0;
+}
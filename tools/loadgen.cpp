@@ -0,0 +1,418 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "answergraph.h"
+#include "chatserver.h"
+#include "conversationengine.h"
+#include "graphedge.h"
+#include "graphloader.h"
+#include "graphnode.h"
+#include "levenshtein.h"
+#include "rng.h"
+#include "textnormalizer.h"
+
+namespace
+{
+// allocations of each thread, counted by the global operator new below
+thread_local uint64_t numAllocations = 0;
+
+struct LoadOptions
+{
+    size_t numSessions = 64;
+    size_t numTurns = 100;    // per session
+    size_t numThreads = 0;    // 0 uses all hardware threads
+    double typoRate = 0.0;    // probability of an edit per character of a message
+    uint64_t seed = 1;
+    bool matchWords = false;
+    size_t cacheCapacity = 0;
+    std::string server;       // host:port, empty to drive the engine in this process
+    double maxP99 = 0.0;      // in microseconds, 0 for no limit
+};
+
+// result of one thread (latencies of all its turns in nanoseconds)
+struct ThreadResult
+{
+    std::vector<uint64_t> latencies;
+    uint64_t numAllocations = 0;
+    bool isFailed = false;
+};
+
+// substitutes, deletes or inserts a random letter at each character with the given probability
+void ApplyTypos(std::string &message, double rate, Pcg32 &rng)
+{
+    if (rate <= 0.0)
+        return;
+
+    std::string noisy;
+    uint32_t threshold = uint32_t(std::min(rate, 1.0) * UINT32_MAX);
+    for (char c : message)
+    {
+        if (rng() >= threshold)
+        {
+            noisy.push_back(c);
+            continue;
+        }
+        char letter = char('a' + rng.NextBelow(26));
+        switch (rng.NextBelow(3))
+        {
+        case 0:
+            noisy.push_back(letter);
+            break;
+        case 1:
+            break;
+        default:
+            noisy.push_back(c);
+            noisy.push_back(letter);
+            break;
+        }
+    }
+    message.swap(noisy);
+}
+
+// random walk over the graph: each message is a keyword of a random child edge of the node the conversation is at;
+// the routing is followed locally, so a keyword spoilt by typos continues wherever the chatbot goes with it
+// (nodes without child edges get a keyword of the root node, after which the conversation is back at the root node)
+std::vector<std::string> CreateScript(const AnswerGraph &graph, const LoadOptions &options, uint64_t session, LevenshteinEngine &engine)
+{
+    Pcg32 rng(options.seed, session);
+    std::vector<std::string> script;
+    std::string normalized;
+    const GraphNode *current = graph.GetRootNode();
+    for (size_t turn = 0; turn < options.numTurns; ++turn)
+    {
+        const GraphNode *node = current->GetNumberOfChildEdges() > 0 ? current : graph.GetRootNode();
+        std::string message;
+        if (node->GetNumberOfChildEdges() > 0)
+        {
+            StringList keywords = node->GetChildEdgeAtIndex(rng.NextBelow(node->GetNumberOfChildEdges()))->GetKeywords();
+            if (keywords.size() > 0)
+                message.assign(keywords[rng.NextBelow(keywords.size())]);
+        }
+        ApplyTypos(message, options.typoRate, rng);
+
+        NormalizeText(message, normalized);
+        current = graph.SelectNextNode(current, normalized, engine);
+        script.push_back(std::move(message));
+    }
+    return script;
+}
+
+// every thread runs its sessions turn by turn, so as many turns as threads are in flight at any time
+void RunEngineThread(ConversationEngine &engine, const std::vector<std::vector<std::string>> &scripts, size_t firstSession, size_t endSession,
+                     std::atomic<bool> &start, ThreadResult &result)
+{
+    std::vector<ConversationEngine::SessionID> sessions;
+    for (size_t i = firstSession; i < endSession; ++i)
+        sessions.push_back(engine.CreateSession());
+    result.latencies.reserve((endSession - firstSession) * (scripts.empty() ? 0 : scripts[0].size()));
+    std::string answer;
+    while (!start.load(std::memory_order_acquire))
+        std::this_thread::yield();
+
+    uint64_t allocationsBefore = numAllocations;
+    for (size_t turn = 0; firstSession < endSession && turn < scripts[firstSession].size(); ++turn)
+    {
+        for (size_t i = firstSession; i < endSession; ++i)
+        {
+            auto begin = std::chrono::steady_clock::now();
+            engine.Respond(sessions[i - firstSession], scripts[i][turn], answer);
+            auto end = std::chrono::steady_clock::now();
+            result.latencies.push_back(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()));
+        }
+    }
+    result.numAllocations = numAllocations - allocationsBefore;
+
+    for (ConversationEngine::SessionID session : sessions)
+        engine.EndSession(session);
+}
+
+int ConnectToServer(const std::string &server)
+{
+    size_t colon = server.rfind(':');
+    if (colon == std::string::npos)
+        return -1;
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *addresses = nullptr;
+    if (getaddrinfo(server.substr(0, colon).c_str(), server.substr(colon + 1).c_str(), &hints, &addresses) != 0)
+        return -1;
+
+    int fd = -1;
+    for (addrinfo *address = addresses; address != nullptr && fd < 0; address = address->ai_next)
+    {
+        fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+        if (fd >= 0 && connect(fd, address->ai_addr, address->ai_addrlen) < 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+
+    int one = 1;
+    if (fd >= 0)
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// one connection per session with one message in flight each; a message is sent as soon as the previous answer
+// (or the greeting) has been received completely
+void RunServerThread(const LoadOptions &options, const std::vector<std::vector<std::string>> &scripts, size_t firstSession, size_t endSession,
+                     std::atomic<bool> &start, ThreadResult &result)
+{
+    struct Connection
+    {
+        int fd;
+        size_t turn;
+        std::string input;
+        std::chrono::steady_clock::time_point sent;
+    };
+
+    std::vector<Connection> connections;
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    for (size_t i = firstSession; i < endSession; ++i)
+    {
+        int fd = ConnectToServer(options.server);
+        if (fd < 0)
+        {
+            std::cerr << "Error: " << options.server << " cannot be reached" << std::endl;
+            result.isFailed = true;
+            break;
+        }
+        connections.push_back(Connection{fd, 0, std::string(), std::chrono::steady_clock::time_point()});
+    }
+    for (size_t i = 0; i < connections.size(); ++i)
+    {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = i;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, connections[i].fd, &event);
+    }
+    while (!start.load(std::memory_order_acquire))
+        std::this_thread::yield();
+
+    // the greeting is the first frame, it is not timed
+    size_t numOpen = result.isFailed ? 0 : connections.size();
+    std::vector<epoll_event> events(256);
+    std::vector<char> buffer(65536);
+    std::string frame;
+    while (numOpen > 0)
+    {
+        int numEvents = epoll_wait(epollFd, events.data(), int(events.size()), 10000);
+        if (numEvents <= 0)
+        {
+            std::cerr << "Error: the server does not answer" << std::endl;
+            result.isFailed = true;
+            break;
+        }
+
+        for (int e = 0; e < numEvents; ++e)
+        {
+            size_t index = size_t(events[e].data.u64);
+            Connection &connection = connections[index];
+            ssize_t numRead = recv(connection.fd, buffer.data(), buffer.size(), 0);
+            if (numRead <= 0)
+            {
+                std::cerr << "Error: the server closed a connection" << std::endl;
+                result.isFailed = true;
+                numOpen = 0;
+                break;
+            }
+            connection.input.append(buffer.data(), size_t(numRead));
+            if (connection.input.size() < 4)
+                continue;
+
+            const unsigned char *header = reinterpret_cast<const unsigned char *>(connection.input.data());
+            size_t length = (size_t(header[0]) << 24) | (size_t(header[1]) << 16) | (size_t(header[2]) << 8) | size_t(header[3]);
+            if (connection.input.size() < 4 + length)
+                continue;
+            connection.input.erase(0, 4 + length);
+
+            auto now = std::chrono::steady_clock::now();
+            if (connection.sent != std::chrono::steady_clock::time_point())
+                result.latencies.push_back(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(now - connection.sent).count()));
+
+            const std::vector<std::string> &script = scripts[firstSession + index];
+            if (connection.turn == script.size())
+            {
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, connection.fd, nullptr);
+                --numOpen;
+                continue;
+            }
+            frame.clear();
+            ChatServer::AppendFrame(frame, script[connection.turn++]);
+            connection.sent = std::chrono::steady_clock::now();
+            if (send(connection.fd, frame.data(), frame.size(), MSG_NOSIGNAL) != ssize_t(frame.size()))
+            {
+                result.isFailed = true;
+                numOpen = 0;
+                break;
+            }
+        }
+    }
+
+    for (Connection &connection : connections)
+        close(connection.fd);
+    close(epollFd);
+}
+
+// resident and peak resident memory of this process in KiB, from /proc/self/status
+void GetMemoryUsage(size_t &rss, size_t &peakRss)
+{
+    rss = peakRss = 0;
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmRSS:") == 0)
+            rss = std::strtoull(line.c_str() + 6, nullptr, 10);
+        else if (line.compare(0, 6, "VmHWM:") == 0)
+            peakRss = std::strtoull(line.c_str() + 6, nullptr, 10);
+    }
+}
+} // namespace
+
+// counting allocator hook, the array and nothrow forms use these as well
+void *operator new(size_t size)
+{
+    ++numAllocations;
+    if (void *pointer = std::malloc(size > 0 ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+// drives many concurrent synthetic conversations through the conversation engine (or a membot_server) and reports
+// throughput, latency percentiles, allocations per turn and memory; the exit status is 3 if --max-p99 is exceeded
+int main(int argc, char *argv[])
+{
+    LoadOptions options;
+    int arg = 1;
+    for (; arg < argc; ++arg)
+    {
+        std::string option(argv[arg]);
+        if (option == "--sessions" && arg + 1 < argc)
+            options.numSessions = std::strtoull(argv[++arg], nullptr, 10);
+        else if (option == "--turns" && arg + 1 < argc)
+            options.numTurns = std::strtoull(argv[++arg], nullptr, 10);
+        else if (option == "--threads" && arg + 1 < argc)
+            options.numThreads = std::strtoull(argv[++arg], nullptr, 10);
+        else if (option == "--typos" && arg + 1 < argc)
+            options.typoRate = std::strtod(argv[++arg], nullptr);
+        else if (option == "--seed" && arg + 1 < argc)
+            options.seed = std::strtoull(argv[++arg], nullptr, 10);
+        else if (option == "--words")
+            options.matchWords = true;
+        else if (option == "--cache" && arg + 1 < argc)
+            options.cacheCapacity = std::strtoull(argv[++arg], nullptr, 10);
+        else if (option == "--server" && arg + 1 < argc)
+            options.server = argv[++arg];
+        else if (option == "--max-p99" && arg + 1 < argc)
+            options.maxP99 = std::strtod(argv[++arg], nullptr);
+        else
+            break;
+    }
+    if (argc != arg + 1 || options.numSessions == 0 || options.numTurns == 0)
+    {
+        std::cout << "Usage: membot_loadgen [--sessions N] [--turns N] [--threads N] [--typos RATE] [--seed N] [--words] [--cache N]" << std::endl
+                  << "                      [--server HOST:PORT] [--max-p99 MICROSECONDS] <answergraph.txt | answergraph.bin>" << std::endl;
+        return 2;
+    }
+    if (options.numThreads == 0)
+        options.numThreads = std::max(1u, std::thread::hardware_concurrency());
+    options.numThreads = std::min(options.numThreads, options.numSessions);
+
+    // the scripts are created up front, so that the timed run does nothing else; with --server the graph
+    // (and --words) must be the same as the server's, otherwise the walks leave the intended paths
+    std::unique_ptr<AnswerGraph> graph = LoadAnswerGraph(argv[arg]);
+    if (graph == nullptr || graph->GetRootNode() == nullptr)
+        return 1;
+    if (options.matchWords)
+        graph->EnableWordMatching();
+    std::vector<std::vector<std::string>> scripts;
+    {
+        LevenshteinEngine levenshtein;
+        for (size_t session = 0; session < options.numSessions; ++session)
+            scripts.push_back(CreateScript(*graph, options, session, levenshtein));
+    }
+    graph->EnableResponseCache(options.cacheCapacity);
+    ConversationEngine engine(std::move(graph), 0, options.seed);
+
+    // sessions are split evenly over the threads, which start together once all sessions are set up
+    std::vector<ThreadResult> results(options.numThreads);
+    std::vector<std::thread> threads;
+    std::atomic<bool> start(false);
+    for (size_t t = 0; t < options.numThreads; ++t)
+    {
+        size_t first = options.numSessions * t / options.numThreads;
+        size_t end = options.numSessions * (t + 1) / options.numThreads;
+        if (options.server.empty())
+            threads.emplace_back(RunEngineThread, std::ref(engine), std::cref(scripts), first, end, std::ref(start), std::ref(results[t]));
+        else
+            threads.emplace_back(RunServerThread, std::cref(options), std::cref(scripts), first, end, std::ref(start), std::ref(results[t]));
+    }
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    for (std::thread &thread : threads)
+        thread.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+    std::vector<uint64_t> latencies;
+    uint64_t allocations = 0;
+    bool isFailed = false;
+    for (const ThreadResult &result : results)
+    {
+        latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+        allocations += result.numAllocations;
+        isFailed = isFailed || result.isFailed;
+    }
+    if (isFailed || latencies.empty())
+        return 1;
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double q) { return double(latencies[std::min(latencies.size() - 1, size_t(q * latencies.size()))]) / 1000.0; };
+    size_t rss, peakRss;
+    GetMemoryUsage(rss, peakRss);
+
+    std::cout << latencies.size() << " turns of " << options.numSessions << " sessions on " << options.numThreads << " threads in " << elapsed.count() << " s ("
+              << size_t(latencies.size() / elapsed.count()) << " turns/s) via " << (options.server.empty() ? "engine" : options.server) << std::endl;
+    std::cout << "latency us: p50 " << percentile(0.5) << ", p90 " << percentile(0.9) << ", p99 " << percentile(0.99) << ", p99.9 " << percentile(0.999)
+              << ", max " << latencies.back() / 1000.0 << std::endl;
+    if (options.server.empty())
+        std::cout << "allocations per turn: " << double(allocations) / latencies.size() << std::endl;
+    std::cout << "rss KiB: " << rss << " (peak " << peakRss << (options.server.empty() ? ")" : ", client only)") << std::endl;
+
+    if (options.maxP99 > 0.0 && percentile(0.99) > options.maxP99)
+    {
+        std::cout << "p99 latency exceeds " << options.maxP99 << " us" << std::endl;
+        return 3;
+    }
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "answergraph.h"
+#include "batchrouter.h"
+#include "graphloader.h"
+
+// replays logged messages against an answer graph: reads "<start node ID><TAB><message>" lines from stdin
+// and writes "<start node ID><TAB><edge ID><TAB><child node ID><TAB><distance>" lines to stdout
+int main(int argc, char *argv[])
+{
+    bool matchWords = false;
+    int arg = 1;
+    if (arg < argc && std::string(argv[arg]) == "--words")
+    {
+        matchWords = true;
+        ++arg;
+    }
+    if (argc - arg < 1 || argc - arg > 2)
+    {
+        std::cout << "Usage: membot_replay [--words] <answergraph.txt | answergraph.bin> [threads] < messages.tsv" << std::endl;
+        return 2;
+    }
+
+    std::unique_ptr<AnswerGraph> graph = LoadAnswerGraph(argv[arg]);
+    if (graph == nullptr)
+        return 1;
+    if (matchWords)
+        graph->EnableWordMatching();
+    BatchRouter router(std::move(graph), argc - arg > 1 ? std::strtoull(argv[arg + 1], nullptr, 10) : 0);
+
+    std::vector<BatchRouter::Request> requests;
+    std::string line;
+    while (std::getline(std::cin, line))
+    {
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos)
+        {
+            std::cout << "Error: line " << requests.size() + 1 << " has no tab" << std::endl;
+            return 1;
+        }
+        requests.push_back(BatchRouter::Request{std::atoi(line.c_str()), line.substr(tab + 1)});
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<BatchRouter::Result> results;
+    router.Route(requests, results);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    for (size_t i = 0; i < requests.size(); ++i)
+        std::cout << requests[i].startNodeID << '\t' << results[i].edgeID << '\t' << results[i].childNodeID << '\t' << results[i].distance << '\n';
+
+    // the summary goes to stderr, so stdout stays machine-readable
+    std::cerr << "Routed " << requests.size() << " messages in " << elapsed.count() * 1000 << " ms on " << router.GetNumberOfThreads() << " threads" << std::endl;
+    return 0;
+}